@@ -5,24 +5,64 @@
  * bfs
  * dfs 
  * not 
+ * strongest 
+ * allpaths 
+ * exclusion 
+ * songfilter 
+ * avoid 
+ * distances 
+ * centrality 
+ * within 
+ * nearest 
+ * suggest 
+ * stats 
  * quit 
  */
  
+ #include <algorithm>
+ #include <unordered_map>
+ #include <functional>
+ #include <cstdlib>
+ #include <mutex>
+ #include <random>
+ #include <chrono>
+ 
  #include "Artist.h"
  #include "CollabGraph.h"
- #include "SixDegrees.h"
+ #include "6degs.h"
+ #include "Traversal.h"
+ #include "Centrality.h"
  using namespace std;
 
+const size_t SixDegrees::PARALLEL_GRAPH;
 
 /*SixDegrees 
  *Arguments: string for the filename 
  *Returns: N/A 
  *Purpose: This constructor takes in a filename and initializes a graph, 
- *         after checking that the file is ok! 
+ *         after checking that the file is ok! A graph file written by
+ *         save is memory-mapped instead of read. loadMemory bounds the
+ *         memory reading a data file uses on top of the graph (see
+ *         GraphBuilder), and normalize interns a data file's names by
+ *         their normal form (see NameFold); a graph file keeps the names
+ *         it was built with.
  */
-SixDegrees::SixDegrees(string filename)
+SixDegrees::SixDegrees(string filename, size_t loadMemory, bool normalize)
 {
-    ifstream data(filename);
+    allSongs = false;
+    threads = 1;
+    if (GraphFile::is_graph_file(filename)) {
+        try {
+            graph.open_file(filename);
+        } catch (const runtime_error &e) {
+            cerr << e.what() << endl;
+            exit(EXIT_FAILURE);
+        }
+        names.build(graph);
+        return;
+    }
+    
+    LineReader data(filename);
     
     //check to see if the input file fails or not
     if (data.fail()) {
@@ -31,9 +71,9 @@ SixDegrees::SixDegrees(string filename)
     }
     
     //assuming reading in works, fill with data.
-    fillGraph(data);
-    // close the data file
-    data.close();
+    graph.normalize_names(normalize);
+    fillGraph(data, loadMemory);
+    names.build(graph);
 }
 
 /*~SixDegrees 
@@ -46,6 +86,46 @@ SixDegrees::~SixDegrees()
     
 }
 
+/*SixDegrees (move)
+ *Arguments: the SixDegrees to take over
+ *Returns: N/A
+ *Purpose: Takes over a loaded graph and everything built on it without
+ *         copying, so a graph can be loaded on one thread and handed to
+ *         another. source is left with an empty graph.
+ */
+SixDegrees::SixDegrees(SixDegrees &&source)
+{
+    allSongs = false;
+    threads = 1;
+    *this = std::move(source);
+}
+
+/*operator= (move)
+ *Arguments: the SixDegrees to take the place of this one
+ *Returns: this SixDegrees
+ *Purpose: Swaps in another graph, with its names, lists and settings, in
+ *         constant time. The two trade places (see CollabGraph's move
+ *         assignment), so rhs frees the old graph when it goes away. No
+ *         other thread may be using either one, so a server swaps between
+ *         requests.
+ */
+SixDegrees &SixDegrees::operator=(SixDegrees &&rhs)
+{
+    if (this == &rhs) return *this;
+    graph = std::move(rhs.graph);
+    swap(state, rhs.state);
+    swap(allSongs, rhs.allSongs);
+    swap(limits, rhs.limits);
+    swap(threads, rhs.threads);
+    places.swap(rhs.places);
+    swap(names, rhs.names);
+    names.rebind(graph); //each index follows its graph to its new home
+    rhs.names.rebind(rhs.graph);
+    exclusionLists.swap(rhs.exclusionLists);
+    songFilters.swap(rhs.songFilters);
+    return *this;
+}
+
 
 /*play
  *arguments: input stream and output stream 
@@ -71,12 +151,492 @@ void SixDegrees::play(istream &input, ostream &output)
         } else if (cmd == "not") {
             prepNot(input, output); 
             
+        } else if (cmd == "strongest") {
+            prepStrongest(input, output);
+            
+        } else if (cmd == "allpaths") {
+            prepAllPaths(input, output);
+            
+        } else if (cmd == "exclusion") {
+            prepExclusion(input, output);
+            
+        } else if (cmd == "songfilter") {
+            prepSongFilter(input, output);
+            
+        } else if (cmd == "avoid") {
+            prepAvoid(input, output);
+            
+        } else if (cmd == "distances") {
+            prepDistances(input, output);
+            
+        } else if (cmd == "centrality") {
+            prepCentrality(input, output);
+            
+        } else if (cmd == "within") {
+            prepWithin(input, output);
+            
+        } else if (cmd == "nearest") {
+            prepNearest(input, output);
+            
+        } else if (cmd == "suggest") {
+            prepSuggest(input, output);
+            
+        } else if (cmd == "stats") {
+            prepStats(output);
+            
         } else { //invalid command 
             output << cmd << " is not a command. Please try again." << endl;
         }
     }
 }
 
+/*play_json
+ *arguments: input stream and output stream
+ *returns: N/A
+ *Purpose: Same command loop as play, but every request is one JSON object
+ *         per line and every reply is one JSON object per line carrying the
+ *         request's "id". Output is only flushed once the input has no more
+ *         buffered requests, so pipelined requests are answered in batches.
+ */
+void SixDegrees::play_json(istream &input, ostream &output)
+{
+    string line;
+    while (not getline(input, line).fail()) {
+        if (not answer_line(line, state, output)) break; //quit
+        
+        //nothing else waiting to be read, so push the replies out now
+        if (input.rdbuf()->in_avail() <= 0) output.flush();
+    }
+    output.flush();
+}
+
+/*answer_line
+ *arguments: one line of JSON input, the search state to use, output stream
+ *returns: false if the line asked to quit, true otherwise
+ *Purpose: Parses and answers one request. Only reads the graph, so many
+ *         threads can call this at once as long as each has its own state.
+ */
+bool SixDegrees::answer_line(const string &line, SearchState &search,
+                             ostream &output) const
+{
+    Request req;
+    string error;
+    if (line.find_first_not_of(" \t\r") == string::npos) return true;
+    
+    if (not parse_request(line, req, error)) {
+        writeError(output, req.id, error);
+    } else if (req.cmd == "quit") {
+        return false;
+    } else {
+        answer(req, search, output);
+    }
+    return true;
+}
+
+/*answer
+ *arguments: a parsed request and the output stream
+ *returns: N/A
+ *Purpose: Runs one bfs/dfs/not request and writes its single line reply.
+ *         The status is "ok" (with a path), "no_path", "not_found" (with the
+ *         names that are not in the dataset) or "error".
+ */
+void SixDegrees::answer(const Request &req, SearchState &search,
+                        ostream &output) const
+{
+    if (req.cmd == "exclusion") {
+        answerExclusion(req, output);
+        return;
+    }
+    if (req.cmd == "songfilter") {
+        answerSongFilter(req, output);
+        return;
+    }
+    if (req.cmd == "centrality") {
+        answerCentrality(req, output);
+        return;
+    }
+    if (req.cmd == "suggest") {
+        answerSuggest(req, output);
+        return;
+    }
+    if (req.cmd == "stats") {
+        answerStats(req, search, output);
+        return;
+    }
+    //distances and within have no "to", nearest has lists of both
+    bool grouped = (req.cmd == "nearest");
+    bool targeted = (req.cmd != "distances" and req.cmd != "within" and
+                     not grouped);
+    if (req.cmd != "bfs" and req.cmd != "dfs" and req.cmd != "not" and
+        req.cmd != "strongest" and req.cmd != "allpaths" and targeted) {
+        writeError(output, req.id, "\"" + req.cmd + "\" is not a command");
+        return;
+    }
+    vector<string> sources = req.get_list("sources");
+    vector<string> targets = req.get_list("targets");
+    if (grouped and (sources.empty() or targets.empty())) {
+        writeError(output, req.id,
+                   "\"sources\" and \"targets\" are required");
+        return;
+    }
+    if (not targeted and not grouped and req.get("from") == "") {
+        writeError(output, req.id, "\"from\" is required");
+        return;
+    }
+    if (targeted and (req.get("from") == "" or req.get("to") == "")) {
+        writeError(output, req.id, "\"from\" and \"to\" are required");
+        return;
+    }
+    Limits reqLimits;
+    if (not readLimits(req, reqLimits, output)) return;
+    
+    vector<string> names = req.get_list("exclude");
+    if (targeted) names.insert(names.begin(), req.get("to"));
+    if (grouped) {
+        names.insert(names.begin(), targets.begin(), targets.end());
+        names.insert(names.begin(), sources.begin(), sources.end());
+    } else {
+        names.insert(names.begin(), req.get("from"));
+    }
+    //the names searched between come before the exclusions
+    size_t ends = grouped ? sources.size() + targets.size()
+                          : targeted ? 2 : 1;
+    
+    //every name must be valid before anything is searched, like checkNot
+    vector<string> missing;
+    vector<size_t> ids;
+    for (size_t i = 0; i < names.size(); i++) {
+        ids.push_back(findArtist(names.at(i)));
+        if (ids.back() == CollabGraph::NO_VERTEX) {
+            missing.push_back(names.at(i));
+        }
+    }
+    if (not missing.empty()) {
+        writeReply(output, req.id, "not_found");
+        output << ",\"names\":[";
+        for (size_t i = 0; i < missing.size(); i++) {
+            if (i > 0) output << ',';
+            write_json_string(output, missing.at(i));
+        }
+        output << "]}\n";
+        return;
+    }
+    
+    search.reset(graph.vertex_count());
+    for (size_t i = ends; i < ids.size(); i++) { //exclusions
+        search.mark(ids.at(i));
+    }
+    
+    //named lists stay locked until the search is done with them
+    shared_lock<shared_mutex> lists(listLock);
+    vector<string> named = req.get_list("exclude_lists");
+    for (size_t i = 0; i < named.size(); i++) {
+        auto list = exclusionLists.find(named.at(i));
+        if (list == exclusionLists.end()) {
+            writeError(output, req.id,
+                       "no exclusion list named \"" + named.at(i) + "\"");
+            return;
+        }
+        search.skip(list->second);
+    }
+    named = req.get_list("song_filters");
+    for (size_t i = 0; i < named.size(); i++) {
+        auto filter = songFilters.find(named.at(i));
+        if (filter == songFilters.end()) {
+            writeError(output, req.id,
+                       "no song filter named \"" + named.at(i) + "\"");
+            return;
+        }
+        search.block_songs(filter->second);
+    }
+    
+    //songs named in the request itself are only blocked for this search
+    VertexSet avoid;
+    vector<string> titles = req.get_list("avoid_songs");
+    for (size_t i = 0; i < titles.size(); i++) {
+        size_t song = graph.find_song(titles.at(i));
+        if (song == CollabGraph::NO_SONG) {
+            writeError(output, req.id,
+                       "no song titled \"" + titles.at(i) + "\"");
+            return;
+        }
+        avoid.insert(song);
+    }
+    if (not avoid.empty()) search.block_songs(avoid);
+    
+    vector<size_t> path; //nearest finds its own ends
+    if (req.cmd == "distances") {
+        writeDistances(output, req, ids.at(0), reqLimits, search);
+        return;
+    } else if (req.cmd == "within") {
+        writeWithin(output, req, ids.at(0), reqLimits, search);
+        return;
+    } else if (req.cmd == "allpaths") {
+        writeAllPaths(output, req, ids.at(0), ids.at(1), search);
+        return;
+    } else if (req.cmd == "dfs") {
+        dfs(ids.at(0), ids.at(1), search);
+    } else if (req.cmd == "strongest") {
+        strongest(ids.at(0), ids.at(1), search);
+    } else {
+        Outcome outcome;
+        if (grouped) {
+            vector<size_t> from(ids.begin(), ids.begin() + sources.size());
+            VertexSet to;
+            for (size_t i = sources.size(); i < ends; i++) to.insert(ids.at(i));
+            outcome = nearest(from, to, reqLimits, search, path);
+        } else {
+            outcome = bfs(ids.at(0), ids.at(1), search, reqLimits);
+        }
+        if (outcome == Outcome::DEPTH_LIMIT) {
+            writeReply(output, req.id, "no_path");
+            output << ",\"within\":" << reqLimits.depth << "}\n";
+            return;
+        } else if (outcome == Outcome::OVER_BUDGET) {
+            writeReply(output, req.id, "budget_exceeded");
+            output << ",\"reached\":" << search.visits().size() << "}\n";
+            return;
+        }
+    }
+    if (not grouped) path = search.path(ids.at(0), ids.at(1));
+    writePath(output, req.id, path,
+              req.cmd == "strongest", req.get("songs") == "true",
+              search.blocked_songs());
+}
+
+/*writeReply
+ *arguments: output stream, the request id and a status
+ *returns: N/A
+ *Purpose: Opens a reply object; the caller adds members and closes it.
+ */
+void SixDegrees::writeReply(ostream &output, const string &id,
+                            const string &status) const
+{
+    output << "{\"id\":" << id << ",\"status\":\"" << status << '"';
+}
+
+/*writeError
+ *arguments: output stream, the request id and a message
+ *returns: N/A
+ *Purpose: Writes a whole "error" reply line.
+ */
+void SixDegrees::writeError(ostream &output, const string &id,
+                            const string &message) const
+{
+    writeReply(output, id, "error");
+    output << ",\"error\":";
+    write_json_string(output, message);
+    output << "}\n";
+}
+
+/*writePath
+ *arguments: output stream, the request id, the path (source first),
+ *           whether to include the strength and all the songs of every hop
+ *           and the songs that may not be named (nullptr for none)
+ *returns: N/A
+ *Purpose: The JSON twin of print. Writes a "no_path" reply, or an "ok" reply
+ *         listing every hop as its vertex ID and name plus the song linking
+ *         it to the hop before it (and how many songs link them, or all of
+ *         those songs, if asked).
+ */
+void SixDegrees::writePath(ostream &output, const string &id,
+                           const vector<size_t> &path, bool strengths,
+                           bool songs, const VertexSet *blocked) const
+{
+    if (path.empty()) {
+        writeReply(output, id, "no_path");
+        output << "}\n";
+        return;
+    }
+    
+    writeReply(output, id, "ok");
+    output << ",\"path\":";
+    writeHops(output, path, strengths, songs, blocked);
+    output << "}\n";
+}
+
+/*writeHops
+ *arguments: output stream, a path (source first), whether to include the
+ *           strength and all the songs of every hop and the blocked songs
+ *returns: N/A
+ *Purpose: Writes a path as a JSON array of hops for writePath/allpaths.
+ *         Blocked songs are never given as the song of a hop, nor counted
+ *         in its strength.
+ */
+void SixDegrees::writeHops(ostream &output, const vector<size_t> &path,
+                           bool strengths, bool songs,
+                           const VertexSet *blocked) const
+{
+    output << '[';
+    for (size_t i = 0; i < path.size(); i++) {
+        output << (i == 0 ? "" : ",") << "{\"artist\":" << path.at(i)
+               << ",\"name\":";
+        write_json_string(output, graph.get_name(path.at(i)));
+        if (i > 0) {
+            vector<size_t> all = usableSongs(path.at(i - 1), path.at(i),
+                                             blocked);
+            output << ",\"song\":";
+            write_json_string(output, graph.get_song(all.at(0)));
+            if (strengths) {
+                output << ",\"strength\":" << all.size(); //usable songs
+            }
+            if (songs) {
+                output << ",\"songs\":[";
+                for (size_t k = 0; k < all.size(); k++) {
+                    if (k > 0) output << ',';
+                    write_json_string(output, graph.get_song(all.at(k)));
+                }
+                output << ']';
+            }
+        }
+        output << '}';
+    }
+    output << ']';
+}
+
+/*writeAllPaths
+ *arguments: output stream, the request, source and destination vertex IDs
+ *           and the search state (holding any exclusions)
+ *returns: N/A
+ *Purpose: The JSON side of allpaths: an "ok" reply with the number of
+ *         shortest paths, their length in "hops" and up to "limit" of them
+ *         (100 if not given, 0 for no limit) written as they are found.
+ *         A negative or malformed "limit" gets an error reply instead.
+ */
+void SixDegrees::writeAllPaths(ostream &output, const Request &req, size_t a,
+                               size_t b, SearchState &search) const
+{
+    long limit = req.has("limit") ? req.get_number("limit", -1) : 100;
+    if (limit < 0) {
+        writeError(output, req.id, "\"limit\" must be a number of at least 0");
+        return;
+    }
+
+    uint64_t count = countPaths(a, b, search);
+    if (count == 0) {
+        writeReply(output, req.id, "no_path");
+        output << "}\n";
+        return;
+    }
+    
+    bool songs = (req.get("songs") == "true");
+    writeReply(output, req.id, "ok");
+    output << ",\"count\":" << count << ",\"hops\":"
+           << search.get_depth(b) << ",\"paths\":[";
+    bool first = true;
+    walkPaths(a, b, limit, search,
+              [&](const vector<size_t> &path) {
+        if (not first) output << ',';
+        writeHops(output, path, false, songs, search.blocked_songs());
+        first = false;
+    });
+    output << "]}\n";
+}
+
+/*readLimits
+ *arguments: a parsed request, the limits to fill and the output stream
+ *returns: false (after replying with an error) if a limit is malformed
+ *Purpose: Starts from the limits given on the command line and replaces
+ *         any that the request gives as "max_depth" (hops), "max_visits"
+ *         (artists reached) or "time_limit_ms" (milliseconds).
+ */
+bool SixDegrees::readLimits(const Request &req, Limits &reqLimits,
+                            ostream &output) const
+{
+    static const char *const keys[] = {"max_depth", "max_visits",
+                                       "time_limit_ms"};
+    size_t *values[] = {&reqLimits.depth, &reqLimits.visits,
+                        &reqLimits.millis};
+    reqLimits = limits;
+    for (size_t i = 0; i < 3; i++) {
+        if (not req.has(keys[i])) continue;
+        long value = req.get_number(keys[i], -1);
+        if (value < 0) {
+            writeError(output, req.id, "\"" + string(keys[i]) +
+                                       "\" must be a number of at least 0");
+            return false;
+        }
+        *values[i] = value;
+    }
+    return true;
+}
+
+/*writeDistances
+ *arguments: output stream, the request, the source vertex ID, its limits
+ *           and the search state (holding any exclusions)
+ *returns: N/A
+ *Purpose: The JSON side of distances: an "ok" reply with how many artists
+ *         are "reached" and how many of them are 1, 2, ... hops away
+ *         ("by_hops"), going at most "max_depth" hops if it is given, or
+ *         "budget_exceeded" if it ran out of visits or time first.
+ */
+void SixDegrees::writeDistances(ostream &output, const Request &req, size_t a,
+                                const Limits &reqLimits,
+                                SearchState &search) const
+{
+    vector<size_t> levels;
+    if (distances(a, reqLimits, search, levels) == Outcome::OVER_BUDGET) {
+        writeReply(output, req.id, "budget_exceeded");
+        output << ",\"reached\":" << search.visits().size() << "}\n";
+        return;
+    }
+    
+    size_t reached = 0;
+    for (size_t i = 0; i < levels.size(); i++) reached += levels.at(i);
+    writeReply(output, req.id, "ok");
+    output << ",\"reached\":" << reached << ",\"by_hops\":[";
+    for (size_t i = 0; i < levels.size(); i++) {
+        if (i > 0) output << ',';
+        output << levels.at(i);
+    }
+    output << "]}\n";
+}
+
+/*writeWithin
+ *arguments: output stream, the request, the source vertex ID, its limits
+ *           and the search state (holding any exclusions)
+ *returns: N/A
+ *Purpose: The JSON side of within: "artists" up to "hops" hops away, as
+ *         {"artist", "name", "hops", "via", "song", "degree"} objects
+ *         written as the search finds them, or the "top" of them with the
+ *         most collaborators. "complete" is false if the search ran out of
+ *         visits or time, in which case the list is what it had found.
+ */
+void SixDegrees::writeWithin(ostream &output, const Request &req, size_t a,
+                             const Limits &reqLimits,
+                             SearchState &search) const
+{
+    long hops = req.get_number("hops", -1);
+    long top = req.get_number("top", 0);
+    if (hops < 1) {
+        writeError(output, req.id, "\"hops\" must be a number of at least 1");
+        return;
+    }
+    if (top < 0) {
+        writeError(output, req.id, "\"top\" must be a number of at least 0");
+        return;
+    }
+    
+    Limits withinLimits = reqLimits;
+    withinLimits.depth = hops;
+    writeReply(output, req.id, "ok");
+    output << ",\"artists\":[";
+    size_t count = 0;
+    Outcome outcome = within(a, withinLimits, top, search,
+                             [&](const Nearby &found) {
+        if (count++ > 0) output << ',';
+        output << "{\"artist\":" << found.artist << ",\"name\":";
+        write_json_string(output, graph.name_view(found.artist));
+        output << ",\"hops\":" << found.hops << ",\"via\":";
+        write_json_string(output, graph.name_view(found.via));
+        output << ",\"song\":";
+        write_json_string(output, graph.song_view(found.song));
+        output << ",\"degree\":" << found.degree << '}';
+    });
+    output << "],\"count\":" << count << ",\"complete\":"
+           << (outcome == Outcome::OVER_BUDGET ? "false" : "true") << "}\n";
+}
+
 /*prepBFS
  *arguments: Input stream and output stream
  *Returns: none 
@@ -84,7 +644,6 @@ void SixDegrees::play(istream &input, ostream &output)
 */
 void SixDegrees::prepBFS(istream &input, ostream &output) 
 {
-    graph.clear_metadata();
     string source, dest;
     getline(input, source); //read in source
     getline(input, dest); //read in destination
@@ -92,45 +651,800 @@ void SixDegrees::prepBFS(istream &input, ostream &output)
     Artist b(dest);
     
     //check to enforce valid vertex, print wrong artist if bad command
-    if (checkDFSBFS(a, b, output)) {
+    size_t from, to;
+    if (checkDFSBFS(a, b, from, to, output)) {
         //Assume eeverything is in order, run bfs. Hooray!
-        bfs(source, dest);
-        print(output, source, dest); //will still check for empty path
+        state.reset(graph.vertex_count()); //clear the marks!
+        //will still check for empty path
+        printOutcome(output, from, to, bfs(from, to, state, limits));
     }
 }
 
 
 /*bfs
- *Arguments: Two artists: 
- *returns: boolean true or false if a path is possible.
+ *Arguments: Two vertex IDs, the search state to record the path in and how
+ *           far the search may go
+ *returns: FOUND if there is a path, NOT_FOUND if there is none, and
+ *         DEPTH_LIMIT or OVER_BUDGET if the limits stopped the search first
  *Purpose: This function uses breadth-first search method to try and find the
- *         shortest path between artist a and artist b
+ *         shortest path between artist a and artist b. Vertices that are
+ *         already marked in the search state (exclusions) are never entered.
+ */
+Outcome SixDegrees::bfs(size_t a, size_t b, SearchState &search,
+                        const Limits &bfsLimits) const
+{
+    //if bfs is called on the same artist entry
+    if (a == b) return Outcome::NOT_FOUND;
+    //possible fix to repeat artists
+    if (search.is_marked(a) or search.is_skipped(a)) return Outcome::NOT_FOUND;
+    
+    //stop at b and record predecessors (see Traversal.h)
+    return breadth_first<true, true, false>(graph, search, a, b, bfsLimits,
+                                            nullptr, searchThreads());
+}
+
+/*prepDistances
+ *Arguments: Input stream and output stream
+ *Returns: none
+ *Purpose: Reads one artist and prints how many other artists it is
+ *         connected to, and how many of them are each number of hops away.
+ */
+void SixDegrees::prepDistances(istream &input, ostream &output)
+{
+    string source;
+    getline(input, source);
+    size_t from = findArtist(source);
+    if (from == CollabGraph::NO_VERTEX) {
+        printBadArt(source, output);
+        return;
+    }
+    
+    state.reset(graph.vertex_count()); //clear the marks!
+    vector<size_t> levels;
+    if (distances(from, limits, state, levels) == Outcome::OVER_BUDGET) {
+        output << "The search from \"" << source
+               << "\" ran out of budget." << endl;
+        return;
+    }
+    size_t reached = 0;
+    for (size_t i = 0; i < levels.size(); i++) reached += levels.at(i);
+    output << "\"" << source << "\" is connected to " << reached
+           << " other artists." << endl;
+    for (size_t i = 0; i < levels.size(); i++) {
+        output << (i + 1) << (i == 0 ? " hop" : " hops") << " away: "
+               << levels.at(i) << endl;
+    }
+    output << "***" << endl;
+}
+
+/*distances
+ *Arguments: a source vertex ID, how far to go, the search state and a
+ *           vector to fill
+ *Returns: how the search ended; levels gets how many artists are 1, 2, ...
+ *         hops from a
+ *Purpose: bfs with no destination: reaches everything within the limits
+ *         of a, counting each level, without recording predecessors.
+ *         Marked (excluded) vertices are left out like in bfs.
+ */
+Outcome SixDegrees::distances(size_t a, const Limits &bfsLimits,
+                              SearchState &search,
+                              vector<size_t> &levels) const
+{
+    levels.clear();
+    if (search.is_marked(a) or search.is_skipped(a)) {
+        return Outcome::NOT_FOUND;
+    }
+    return breadth_first<false, false, true>(graph, search, a,
+                                             CollabGraph::NO_VERTEX,
+                                             bfsLimits, &levels,
+                                             searchThreads());
+}
+
+/*prepWithin
+ *Arguments: Input stream and output stream
+ *Returns: none
+ *Purpose: Reads one artist, how many hops to go and how many artists to
+ *         list (0 for all), and lists every artist that many hops or fewer
+ *         away with the hop that reached it, nearest first, or the ones
+ *         with the most collaborators first if the list is capped.
+ */
+void SixDegrees::prepWithin(istream &input, ostream &output)
+{
+    string source, hopsLine, topLine;
+    getline(input, source);
+    getline(input, hopsLine);
+    getline(input, topLine);
+    size_t from = findArtist(source);
+    if (from == CollabGraph::NO_VERTEX) {
+        printBadArt(source, output);
+        return;
+    }
+    
+    char *end = nullptr;
+    unsigned long hops = strtoul(hopsLine.c_str(), &end, 10);
+    if (hopsLine.empty() or *end != '\0' or hops == 0) {
+        output << "\"" << hopsLine << "\" is not a number of hops." << endl;
+        return;
+    }
+    unsigned long top = strtoul(topLine.c_str(), &end, 10);
+    if (topLine.empty() or *end != '\0') {
+        output << "\"" << topLine << "\" is not a number of artists."
+               << endl;
+        return;
+    }
+    
+    state.reset(graph.vertex_count()); //clear the marks!
+    Limits withinLimits = limits;
+    withinLimits.depth = hops;
+    if (top > 0) output << "The " << top << " best connected artists";
+    else output << "Artists";
+    output << " within " << hops << (hops == 1 ? " hop" : " hops")
+           << " of \"" << source << "\":" << endl;
+    //'\n' rather than endl: there can be hundreds of thousands of lines
+    Outcome outcome = within(from, withinLimits, top, state,
+                             [&](const Nearby &found) {
+        output << "\"" << graph.name_view(found.artist) << "\" ("
+               << found.hops << (found.hops == 1 ? " hop" : " hops")
+               << ") collaborated with \"" << graph.name_view(found.via)
+               << "\" in \"" << graph.song_view(found.song) << "\".\n";
+    });
+    if (outcome == Outcome::OVER_BUDGET) {
+        output << "The search from \"" << source
+               << "\" ran out of budget." << endl;
+    }
+    output << "***" << endl;
+}
+
+/*within
+ *Arguments: a source vertex ID, how far to go (the depth is the number of
+ *           hops), how many artists to keep (0 for all), the search state
+ *           and what to do with each artist
+ *Returns: how the search ended; OVER_BUDGET means some artists are missing
+ *Purpose: bfs with no destination that hands every artist it finds to
+ *         emit as it finds them, level by level, with the artist and song
+ *         it was found through, so nothing is kept per artist. With a top
+ *         count only that many are kept, the ones with the highest degree
+ *         (ties by vertex ID) in a heap, and emitted best first at the end.
+ */
+Outcome SixDegrees::within(size_t a, const Limits &bfsLimits, size_t top,
+                           SearchState &search,
+                           const function<void(const Nearby &)> &emit) const
+{
+    if (search.is_marked(a) or search.is_skipped(a)) {
+        return Outcome::NOT_FOUND;
+    }
+    const VertexSet *blocked = search.blocked_songs();
+    auto found = [&](size_t vertex, size_t from,
+                     const CollabGraph::Neighbors &edge, size_t hops) {
+        size_t song = blocked == nullptr ? edge.first_song()
+                                         : edge.open_song(*blocked);
+        return Nearby{vertex, from, song, hops, graph.degree(vertex)};
+    };
+    if (top == 0) {
+        return breadth_first<false, false, true>(graph, search, a,
+            CollabGraph::NO_VERTEX, bfsLimits, nullptr, 1,
+            [&](size_t vertex, size_t from,
+                const CollabGraph::Neighbors &edge, size_t hops) {
+                emit(found(vertex, from, edge, hops));
+                return false; //never stop early
+            });
+    }
+    
+    //the worst of the best so far is on top of the heap
+    auto better = [](const Nearby &x, const Nearby &y) {
+        if (x.degree != y.degree) return x.degree > y.degree;
+        return x.artist < y.artist;
+    };
+    vector<Nearby> best;
+    Outcome outcome = breadth_first<false, false, true>(graph, search, a,
+        CollabGraph::NO_VERTEX, bfsLimits, nullptr, 1,
+        [&](size_t vertex, size_t from,
+            const CollabGraph::Neighbors &edge, size_t hops) {
+            if (best.size() == top and
+                graph.degree(vertex) < best.front().degree) return false;
+            Nearby next = found(vertex, from, edge, hops);
+            if (best.size() == top) {
+                if (not better(next, best.front())) return false;
+                pop_heap(best.begin(), best.end(), better);
+                best.back() = next;
+            } else {
+                best.push_back(next);
+            }
+            push_heap(best.begin(), best.end(), better);
+            return false;
+        });
+    sort_heap(best.begin(), best.end(), better);
+    for (size_t i = 0; i < best.size(); i++) emit(best.at(i));
+    return outcome;
+}
+
+/*prepNearest
+ *Arguments: Input stream and output stream
+ *Returns: none
+ *Purpose: Reads two lists of artists, each ending with "*", and prints the
+ *         shortest path from any artist on the first list to any artist on
+ *         the second, as bfs would between the two ends it found.
+ */
+void SixDegrees::prepNearest(istream &input, ostream &output)
+{
+    vector<Artist> lists[2];
+    string newArtist;
+    for (size_t i = 0; i < 2; i++) {
+        while (not getline(input, newArtist).fail() and newArtist != "*") {
+            lists[i].push_back(Artist(newArtist));
+        }
+    }
+    vector<size_t> sources, targetIds;
+    bool legit = checkNot(lists[0], sources, output);
+    if (not checkNot(lists[1], targetIds, output) or not legit) return;
+    if (sources.empty() or targetIds.empty()) {
+        output << "nearest needs at least one artist on each list." << endl;
+        return;
+    }
+    
+    VertexSet targets;
+    for (size_t i = 0; i < targetIds.size(); i++) {
+        targets.insert(targetIds.at(i));
+    }
+    state.reset(graph.vertex_count()); //clear the marks!
+    vector<size_t> path;
+    Outcome outcome = nearest(sources, targets, limits, state, path);
+    if (outcome == Outcome::DEPTH_LIMIT) {
+        output << "A path does not exist between the two lists within "
+               << limits.depth << (limits.depth == 1 ? " hop." : " hops.")
+               << endl;
+    } else if (outcome == Outcome::OVER_BUDGET) {
+        output << "The search for a path between the two lists ran out of "
+               << "budget." << endl;
+    } else if (outcome == Outcome::NOT_FOUND) {
+        output << "A path does not exist between the two lists." << endl;
+    } else if (path.size() == 1) {
+        output << "\"" << graph.get_name(path.at(0))
+               << "\" is on both lists." << endl;
+        output << "***" << endl;
+    } else {
+        size_t hops = path.size() - 1;
+        output << "The nearest pair is \"" << graph.get_name(path.front())
+               << "\" and \"" << graph.get_name(path.back()) << "\", "
+               << hops << (hops == 1 ? " hop" : " hops") << " apart."
+               << endl;
+        printPath(output, path);
+    }
+}
+
+/*nearest
+ *Arguments: the source vertex IDs, the targets, how far to go, the search
+ *           state and a vector to fill
+ *Returns: how the search ended; path gets the shortest path from any
+ *         source to any target if one was FOUND (just the artist, if a
+ *         source is a target)
+ *Purpose: One bfs from every source at once, which ends at the first
+ *         target it finds, instead of a bfs per pair. Sources are searched
+ *         from together, so ties go to the pair bfs order finds first.
+ *         Marked (excluded) and skipped sources are left out.
+ */
+Outcome SixDegrees::nearest(const vector<size_t> &sources,
+                            const VertexSet &targets, const Limits &bfsLimits,
+                            SearchState &search, vector<size_t> &path) const
+{
+    path.clear();
+    vector<size_t> open; //the sources the search may start from
+    for (size_t i = 0; i < sources.size(); i++) {
+        size_t a = sources.at(i);
+        if (search.is_marked(a) or search.is_skipped(a)) continue;
+        if (targets.contains(a)) { //no need to search
+            path.push_back(a);
+            return Outcome::FOUND;
+        }
+        open.push_back(a);
+    }
+    if (open.empty()) return Outcome::NOT_FOUND;
+    
+    size_t hit = CollabGraph::NO_VERTEX;
+    Outcome outcome = breadth_first<false, true, false>(graph, search, open,
+        CollabGraph::NO_VERTEX, bfsLimits, nullptr, 1,
+        [&](size_t vertex, size_t, const CollabGraph::Neighbors &, size_t) {
+            if (not targets.contains(vertex)) return false;
+            hit = vertex;
+            return true; //the first target found is a nearest one
+        });
+    if (outcome != Outcome::FOUND) return outcome;
+    
+    //back to whichever source it came from, which has no predecessor
+    for (size_t at = hit; at != CollabGraph::NO_VERTEX;
+         at = search.get_predecessor(at)) {
+        path.push_back(at);
+    }
+    reverse(path.begin(), path.end());
+    return outcome;
+}
+
+/*prepSuggest
+ *Arguments: Input stream and output stream
+ *Returns: none
+ *Purpose: Reads what was typed of a name and how many artists to list,
+ *         and lists the artists whose names are most like it: the same
+ *         name, then names that start with it, then names that look like a
+ *         misspelling of it (see NameIndex).
+ */
+void SixDegrees::prepSuggest(istream &input, ostream &output)
+{
+    string text, countLine;
+    getline(input, text);
+    getline(input, countLine);
+    
+    char *end = nullptr;
+    unsigned long count = strtoul(countLine.c_str(), &end, 10);
+    if (countLine.empty() or *end != '\0') {
+        output << "\"" << countLine << "\" is not a number of artists."
+               << endl;
+        return;
+    }
+    
+    vector<size_t> found = names.suggest(text, count);
+    output << "Artists like \"" << text << "\":" << endl;
+    for (size_t i = 0; i < found.size(); i++) {
+        output << (i + 1) << ". \"" << graph.name_view(found.at(i)) << "\""
+               << endl;
+    }
+    output << "***" << endl;
+}
+
+/*answerSuggest
+ *arguments: a parsed "suggest" request and the output stream
+ *returns: N/A
+ *Purpose: The JSON side of prepSuggest: up to "top" (10 if not given)
+ *         artists like "text", as a list of {"artist", "name"}, best first.
+ */
+void SixDegrees::answerSuggest(const Request &req, ostream &output) const
+{
+    long count = req.get_number("top", 10);
+    if (count < 0) {
+        writeError(output, req.id, "\"top\" must be a number of at least 0");
+        return;
+    }
+    
+    vector<size_t> found = names.suggest(req.get("text"), count);
+    writeReply(output, req.id, "ok");
+    output << ",\"artists\":[";
+    for (size_t i = 0; i < found.size(); i++) {
+        if (i > 0) output << ',';
+        output << "{\"artist\":" << found.at(i) << ",\"name\":";
+        write_json_string(output, graph.name_view(found.at(i)));
+        output << '}';
+    }
+    output << "]}\n";
+}
+
+/*prepCentrality
+ *Arguments: Input stream and output stream
+ *Returns: none
+ *Purpose: Reads how many artists to list and how many to search from (0
+ *         for every artist), and lists the top artists by degree, closeness
+ *         and betweenness (see Centrality.h).
+ */
+void SixDegrees::prepCentrality(istream &input, ostream &output)
+{
+    string countLine, samplesLine;
+    getline(input, countLine);
+    getline(input, samplesLine);
+    
+    char *end = nullptr;
+    unsigned long count = strtoul(countLine.c_str(), &end, 10);
+    if (countLine.empty() or *end != '\0') {
+        output << "\"" << countLine << "\" is not a number of artists."
+               << endl;
+        return;
+    }
+    unsigned long samples = strtoul(samplesLine.c_str(), &end, 10);
+    if (samplesLine.empty() or *end != '\0') {
+        output << "\"" << samplesLine << "\" is not a number of artists."
+               << endl;
+        return;
+    }
+    
+    Centrality scores(graph, samples, threads);
+    string from = scores.sources() == graph.vertex_count() ? "every artist"
+                  : to_string(scores.sources()) + " artists";
+    const char *titles[] = {"degree", "closeness", "betweenness"};
+    vector<Centrality::Score> lists[] = {scores.top_degree(count),
+                                         scores.top_closeness(count),
+                                         scores.top_betweenness(count)};
+    for (size_t i = 0; i < 3; i++) {
+        output << "Top " << lists[i].size() << " artists by " << titles[i];
+        if (i > 0) output << " (searched from " << from << ")";
+        output << ":" << endl;
+        for (size_t j = 0; j < lists[i].size(); j++) {
+            output << (j + 1) << ". \"" << graph.get_name(lists[i][j].id)
+                   << "\" " << lists[i][j].score << endl;
+        }
+    }
+    output << "***" << endl;
+}
+
+/*answerCentrality
+ *arguments: a parsed "centrality" request and the output stream
+ *returns: N/A
+ *Purpose: The JSON side of prepCentrality: "top" artists (10 if not given)
+ *         searched from "samples" artists (256 if not given, 0 for all).
+ *         The reply has how many "sources" were searched and "degree",
+ *         "closeness" and "betweenness" lists of {"artist", "name",
+ *         "score"}, best first.
  */
-bool SixDegrees::bfs(const Artist &a, const Artist &b)
+void SixDegrees::answerCentrality(const Request &req, ostream &output) const
 {
-    if (a == b) return false; //if bfs is called on the same artist entry
-    if (graph.is_marked(a)) return false; //possible fix to repeat artists
-    queue<Artist> musix;
+    long count = req.get_number("top", 10);
+    long samples = req.get_number("samples", 256);
+    if (count < 0 or samples < 0) {
+        writeError(output, req.id,
+                   "\"top\" and \"samples\" must be at least 0");
+        return;
+    }
+    
+    Centrality scores(graph, samples, threads);
+    const char *titles[] = {"degree", "closeness", "betweenness"};
+    vector<Centrality::Score> lists[] = {scores.top_degree(count),
+                                         scores.top_closeness(count),
+                                         scores.top_betweenness(count)};
+    writeReply(output, req.id, "ok");
+    output << ",\"sources\":" << scores.sources();
+    for (size_t i = 0; i < 3; i++) {
+        output << ",\"" << titles[i] << "\":[";
+        for (size_t j = 0; j < lists[i].size(); j++) {
+            if (j > 0) output << ',';
+            output << "{\"artist\":" << lists[i][j].id << ",\"name\":";
+            write_json_string(output, graph.get_name(lists[i][j].id));
+            output << ",\"score\":" << lists[i][j].score << '}';
+        }
+        output << ']';
+    }
+    output << "}\n";
+}
+
+/*prepStats
+ *arguments: output stream
+ *returns: N/A
+ *Purpose: Prints how big the graph is, how many collaborators its artists
+ *         have and how many artists its components hold (in buckets that
+ *         double in width, see GraphStats.h), and the bytes each part of
+ *         the program's data holds
+ */
+void SixDegrees::prepStats(ostream &output)
+{
+    GraphStats stats(graph);
+    output << "Artists: " << stats.artists() << endl
+           << "Edges: " << stats.edges() << " (" << stats.shared_songs()
+           << " songs shared in all)" << endl
+           << "Songs: " << stats.songs() << endl
+           << "Degrees: min " << stats.min_degree() << ", median "
+           << stats.median_degree() << ", mean " << stats.mean_degree()
+           << ", max " << stats.max_degree() << endl;
+    vector<GraphStats::Bucket> buckets = stats.degree_buckets();
+    for (size_t i = 0; i < buckets.size(); i++) {
+        if (buckets[i].count == 0) continue;
+        output << "  " << buckets[i].low;
+        if (buckets[i].high > buckets[i].low) output << "-" << buckets[i].high;
+        output << ": " << buckets[i].count << " artists" << endl;
+    }
+    output << "Components: " << stats.components() << ", the largest with "
+           << stats.largest_component() << " artists" << endl;
+    buckets = stats.component_buckets();
+    for (size_t i = 0; i < buckets.size(); i++) {
+        if (buckets[i].count == 0) continue;
+        output << "  " << buckets[i].low;
+        if (buckets[i].high > buckets[i].low) output << "-" << buckets[i].high;
+        output << " artists: " << buckets[i].count << " components" << endl;
+    }
+    output << "Memory:" << endl;
+    vector<Usage> usage = memoryUsage(state);
+    for (size_t i = 0; i < usage.size(); i++) {
+        output << "  " << usage[i].label << ": " << usage[i].bytes
+               << " bytes" << endl;
+    }
+    output << "***" << endl;
+}
+
+/*answerStats
+ *arguments: a parsed "stats" request, the search state answering it and
+ *           the output stream
+ *returns: N/A
+ *Purpose: The JSON side of prepStats. The reply has "artists", "edges",
+ *         "songs" and "shared", "degree" and "components" objects with
+ *         their totals and "buckets" of {"low", "high", "count"}, and a
+ *         "memory" object of bytes per part, ending with "total".
+ */
+void SixDegrees::answerStats(const Request &req, const SearchState &search,
+                             ostream &output) const
+{
+    GraphStats stats(graph);
+    writeReply(output, req.id, "ok");
+    output << ",\"artists\":" << stats.artists()
+           << ",\"edges\":" << stats.edges()
+           << ",\"songs\":" << stats.songs()
+           << ",\"shared\":" << stats.shared_songs()
+           << ",\"degree\":{\"min\":" << stats.min_degree()
+           << ",\"median\":" << stats.median_degree()
+           << ",\"mean\":" << stats.mean_degree()
+           << ",\"max\":" << stats.max_degree() << ",\"buckets\":[";
+    vector<GraphStats::Bucket> buckets = stats.degree_buckets();
+    for (size_t i = 0; i < buckets.size(); i++) {
+        if (i > 0) output << ',';
+        output << "{\"low\":" << buckets[i].low << ",\"high\":"
+               << buckets[i].high << ",\"count\":" << buckets[i].count
+               << '}';
+    }
+    output << "]},\"components\":{\"count\":" << stats.components()
+           << ",\"largest\":" << stats.largest_component()
+           << ",\"buckets\":[";
+    buckets = stats.component_buckets();
+    for (size_t i = 1; i < buckets.size(); i++) {
+        if (i > 1) output << ',';
+        output << "{\"low\":" << buckets[i].low << ",\"high\":"
+               << buckets[i].high << ",\"count\":" << buckets[i].count
+               << '}';
+    }
+    output << "]},\"memory\":{";
+    vector<Usage> usage = memoryUsage(search);
+    for (size_t i = 0; i < usage.size(); i++) {
+        if (i > 0) output << ',';
+        output << '"' << usage[i].key << "\":" << usage[i].bytes;
+    }
+    output << "}}\n";
+}
+
+/*memoryUsage
+ *arguments: the search state of the command asking
+ *returns: the bytes each part of the program's data holds, and the total
+ *Purpose: Capacity planning. The graph reports its own parts (see
+ *         CollabGraph::memory); on top of it are the name index, the
+ *         searches' marks and predecessors (the graph's own, and the
+ *         asking command's, which the server has one of per worker), the
+ *         registered exclusion lists and song filters, and the data file
+ *         places. Nothing is copied to count them.
+ */
+vector<SixDegrees::Usage> SixDegrees::memoryUsage(const SearchState &search)
+    const
+{
+    CollabGraph::Memory parts = graph.memory();
+    size_t lists = 0;
+    {
+        shared_lock<shared_mutex> hold(listLock);
+        for (auto itr = exclusionLists.begin(); itr != exclusionLists.end();
+             itr++) {
+            lists += itr->first.capacity() + itr->second.bytes();
+        }
+        for (auto itr = songFilters.begin(); itr != songFilters.end();
+             itr++) {
+            lists += itr->first.capacity() + itr->second.bytes();
+        }
+    }
+    vector<Usage> usage = {
+        {"names", "artist names and song titles", parts.names},
+        {"maps", "name maps", parts.maps},
+        {"vertices", "vertex records and ID tables", parts.vertices},
+        {"adjacency", "adjacency lists", parts.adjacency},
+        {"pool", "song pool", parts.pool},
+        {"slack", "unused arena", parts.slack},
+        {"mapped", "mapped graph file", parts.mapped},
+        {"index", "name index", names.bytes()},
+        {"searches", "search state", parts.metadata + search.bytes()},
+        {"lists", "exclusion lists and song filters", lists},
+        {"places", "data file places", places.capacity() * sizeof(size_t)}
+    };
+    size_t total = 0;
+    for (size_t i = 0; i < usage.size(); i++) total += usage[i].bytes;
+    usage.push_back(Usage{"total", "total", total});
+    return usage;
+}
+
+/*prepStrongest
+ *arguments: Input stream and output stream
+ *Returns: none 
+ *Purpose: This function gets the two artists for strongest and prints the
+ *         path that the strongest collaborations make between them
+ */
+void SixDegrees::prepStrongest(istream &input, ostream &output) 
+{
+    string source, dest;
+    getline(input, source); //read in source
+    getline(input, dest); //read in destination
+    Artist a(source);
+    Artist b(dest);
+    
+    size_t from, to;
+    if (checkDFSBFS(a, b, from, to, output)) {
+        state.reset(graph.vertex_count()); //clear the marks!
+        strongest(from, to, state);
+        print(output, from, to);
+    }
+}
+
+/*strongest
+ *Arguments: Two vertex IDs and the search state to record the path in
+ *returns: boolean true or false if a path is possible.
+ *Purpose: Dijkstra's algorithm where a hop between two artists costs
+ *         1 / (number of songs they share), so the path it finds leans on
+ *         the strongest collaborations instead of the fewest hops. A vertex
+ *         is marked once its cost is final; vertices marked beforehand
+ *         (exclusions) are never entered. With songs blocked, only the
+ *         songs a hop may still use count towards its strength.
+ */
+bool SixDegrees::strongest(size_t a, size_t b, SearchState &search) const
+{
+    if (a == b) return false; //same as bfs
+    if (search.is_marked(a) or search.is_skipped(a)) return false;
+    const VertexSet *blocked = search.blocked_songs();
+    DaryHeap &queue = search.queue();
+    search.set_cost(a, 0.0);
+    queue.push(a, 0.0);
+    
+    while (not queue.empty()) {
+        size_t currArt = queue.pop();
+        search.mark(currArt); //cheapest way here is final now
+        if (currArt == b) return true;
+        double here = search.get_cost(currArt);
+        
+        CollabGraph::Neighbors edge = graph.neighbors(currArt);
+        while (edge.next()) {
+            size_t temp = edge.neighbor();
+            if (search.is_marked(temp) or search.is_skipped(temp)) continue;
+            size_t usable = blocked == nullptr ? edge.strength()
+                                               : edge.open_songs(*blocked);
+            if (usable == 0) continue; //every song on it is blocked
+            
+            double cost = here + 1.0 / usable;
+            if (cost < search.get_cost(temp)) { //found a cheaper way there
+                search.set_cost(temp, cost);
+                search.replace_predecessor(temp, currArt);
+                queue.push(temp, cost);
+            }
+        }
+    }
+    return false;
+}
+
+/*prepAllPaths
+ *arguments: Input stream and output stream
+ *Returns: none 
+ *Purpose: This function reads the two artists and a limit for allpaths,
+ *         prints how many shortest paths connect them and then prints up
+ *         to 'limit' of those paths (every one of them if the limit is 0)
+ */
+void SixDegrees::prepAllPaths(istream &input, ostream &output) 
+{
+    string source, dest, count;
+    getline(input, source); //read in source
+    getline(input, dest); //read in destination
+    getline(input, count); //read in how many paths to print
+    Artist a(source);
+    Artist b(dest);
+    
+    char *end = nullptr;
+    unsigned long limit = strtoul(count.c_str(), &end, 10);
+    if (count.empty() or *end != '\0') {
+        output << "\"" << count << "\" is not a number of paths." << endl;
+        return;
+    }
+    
+    size_t from, to;
+    if (checkDFSBFS(a, b, from, to, output)) {
+        state.reset(graph.vertex_count()); //clear the marks!
+        uint64_t paths = countPaths(from, to, state);
+        if (paths == 0) {
+            output << "A path does not exist between \"" << source
+                   << "\" and \"" << dest << "\"." << endl;
+            return;
+        }
+        
+        output << (paths == UINT64_MAX ? "At least " : "") << paths
+               << " shortest path" << (paths == 1 ? "" : "s") << " of "
+               << state.get_depth(to) << " hops between \"" << source
+               << "\" and \"" << dest << "\"." << endl;
+        walkPaths(from, to, limit, state, [&](const vector<size_t> &path) {
+            printPath(output, path);
+        });
+    }
+}
+
+/*countPaths
+ *Arguments: Two vertex IDs and the search state to record the levels in
+ *returns: how many shortest paths there are from a to b (0 if none, and
+ *         UINT64_MAX if at least that many)
+ *Purpose: One breadth-first search that gives every vertex its depth and
+ *         its number of shortest paths from a: a vertex one level down adds
+ *         the count of every neighbor it can be reached from. That is the
+ *         whole shortest path DAG, without storing any of its edges. It
+ *         stops once the level holding b is complete. Vertices that are
+ *         marked beforehand (exclusions) are never entered.
+ */
+uint64_t SixDegrees::countPaths(size_t a, size_t b, SearchState &search) const
+{
+    if (a == b) return 0; //same as bfs
+    if (search.is_marked(a) or search.is_skipped(a)) return 0;
+    queue<size_t> musix;
     musix.push(a);
+    search.mark(a);
+    search.set_depth(a, 0);
+    search.add_paths(a, 1);
     
+    size_t found = SearchState::NO_DEPTH;
     while (not musix.empty()) {
-        Artist currArt = musix.front();
+        size_t currArt = musix.front();
         musix.pop();
-        graph.mark_vertex(currArt);
-        vector<Artist> neighbors = graph.get_vertex_neighbors(currArt);
+        size_t level = search.get_depth(currArt);
+        if (level >= found) break; //every way into b's level is counted
+        uint64_t paths = search.get_paths(currArt);
         
-        //loop through all the neighbors for each vertex, marking predecessor
-        for (size_t i = 0; i < neighbors.size(); i++) {
-            Artist temp = neighbors.at(i);
+        CollabGraph::Neighbors edge = graph.neighbors(currArt);
+        while (edge.next()) {
+            size_t temp = edge.neighbor();
+            if (search.is_skipped(temp)) continue;
+            if (blockedEdge(edge, search)) continue;
             
-            if (not graph.is_marked(temp)) {
-                graph.set_predecessor(temp, currArt);
-                musix.push(temp); //push neighbors onto the queue
-                if (temp == b) return true;              
+            if (not search.is_marked(temp)) {
+                search.mark(temp);
+                search.set_depth(temp, level + 1);
+                search.add_paths(temp, paths);
+                if (temp == b) found = level + 1;
+                musix.push(temp);
+            } else if (search.get_depth(temp) == level + 1) {
+                search.add_paths(temp, paths); //another way in
             }
         }
     }
-    return false;
+    return search.get_paths(b);
+}
+
+/*walkPaths
+ *Arguments: Two vertex IDs, the most paths to produce (0 for all), the
+ *           search state filled in by countPaths and what to do with each
+ *returns: how many paths were produced
+ *Purpose: Walks the shortest path DAG backwards from b, one path at a time,
+ *         handing each finished path (source first) to 'emit'. Only the
+ *         path being built is held in memory, so even a count in the
+ *         billions costs nothing until paths are actually asked for. Every
+ *         neighbor one level closer to a is on some shortest path, so the
+ *         walk never runs into a dead end.
+ */
+size_t SixDegrees::walkPaths(size_t a, size_t b, size_t limit,
+                             const SearchState &search,
+                             const function<void(const vector<size_t> &)>
+                                 &emit) const
+{
+    vector<size_t> path(1, b); //b first, grows toward a
+    vector<CollabGraph::Neighbors> next(1, graph.neighbors(b)); //where each
+                                                                //step is at
+    vector<size_t> forward;
+    size_t produced = 0;
+    
+    while (not path.empty() and (limit == 0 or produced < limit)) {
+        size_t currArt = path.back();
+        if (currArt == a) { //one complete path, hand it over source first
+            forward.assign(path.rbegin(), path.rend());
+            emit(forward);
+            produced++;
+            path.pop_back();
+            next.pop_back();
+            continue;
+        }
+        
+        size_t want = search.get_depth(currArt) - 1;
+        CollabGraph::Neighbors &edge = next.back();
+        bool more;
+        while ((more = edge.next()) and
+               (search.get_depth(edge.neighbor()) != want or
+                blockedEdge(edge, search))) {
+        }
+        if (not more) { //every way back from here is done
+            path.pop_back();
+            next.pop_back();
+            continue;
+        }
+        size_t temp = edge.neighbor(); //edge dies when 'next' grows
+        path.push_back(temp);
+        next.push_back(graph.neighbors(temp));
+    }
+    return produced;
 }
 
 /*artistLookup
@@ -142,11 +1456,9 @@ bool SixDegrees::bfs(const Artist &a, const Artist &b)
 Artist SixDegrees::artistLookup(string name)
 {
     Artist a;
-    for (size_t i = 0; i < artistList.size(); i++) {
-        
-        if (artistList.at(i).get_name() == name) {
-            a = artistList.at(i); //get artist from vector of artists.
-        } 
+    size_t id = findArtist(name);
+    if (id != CollabGraph::NO_VERTEX) {
+        a = graph.get_vertex(id); //the graph is the list of artists now
     }
     return a;
     
@@ -162,6 +1474,16 @@ void SixDegrees::printBadArt(string name, ostream &output)
     output << "\"" << name << "\" was not found in the dataset :(" << endl;
 }
 
+/*printBadSong
+ *Arguments: Song title(string) and output stream 
+ *returns: void, prints to output stream 
+ *Purpose: printBadArt for the song titles of songfilter and avoid
+ */
+void SixDegrees::printBadSong(string title, ostream &output)
+{
+    output << "\"" << title << "\" is not a song in the dataset :(" << endl;
+}
+
 /*prepDFS
  *arguments: Input stream and output stream 
  *Returns: none 
@@ -170,7 +1492,6 @@ void SixDegrees::printBadArt(string name, ostream &output)
  */
 void SixDegrees::prepDFS(istream &input, ostream &output) 
 {
-    graph.clear_metadata(); //clear the graph!
     string source, dest;
     getline(input, source); //get source
     getline(input, dest); //get destination
@@ -179,34 +1500,38 @@ void SixDegrees::prepDFS(istream &input, ostream &output)
     //find artist a and find artist b
     
     //check to enforce valid vertex and print out error messages if neeeded
-    if (checkDFSBFS(a, b, output)) {
-        dfs(a, b);
-        print(output, a, b);
+    size_t from, to;
+    if (checkDFSBFS(a, b, from, to, output)) {
+        state.reset(graph.vertex_count()); //clear the marks!
+        dfs(from, to, state);
+        print(output, from, to);
     }
 }
 
 
 /*dfs
- *arguments: artist source and artist destination 
- *Returns: bool value to indicate if path is possible 
+ *arguments: source and destination vertex IDs and the search state
+ *Returns: bool value that is true when called on the destination itself
  *Purpose: This functiton uses a recursive depth first search to find any 
  *         possible path between 2 artists. Uses recursion to keep the flow
  *         of a stack/Last In First Out
  */
-bool SixDegrees::dfs(const Artist &a, const Artist &b) 
+bool SixDegrees::dfs(size_t a, size_t b, SearchState &search) const
 {
-    graph.mark_vertex(a); //mark the vertex we are currently on.
+    if (search.is_skipped(a)) return false; //an excluded source goes nowhere
+    search.mark(a); //mark the vertex we are currently on.
     if (a == b) {
         return true; //recursive case once we find the desired artist
         
     } else { //keep looking
         //find all the neighbors of the current artist
-        vector<Artist> neighbors = graph.get_vertex_neighbors(a);
-        for (size_t i = 0; i < neighbors.size(); i ++) {
-            Artist temp = neighbors.at(i); //set a temp artist
-            if (not graph.is_marked(temp)) { 
-                graph.set_predecessor(temp, a); //set predecessor 
-                dfs(temp, b); //recurse with the neighbor! 
+        CollabGraph::Neighbors edge = graph.neighbors(a);
+        while (edge.next()) {
+            size_t temp = edge.neighbor(); //set a temp artist
+            if (blockedEdge(edge, search)) continue;
+            if (not search.is_marked(temp) and not search.is_skipped(temp)) { 
+                search.set_predecessor(temp, a); //set predecessor 
+                dfs(temp, b, search); //recurse with the neighbor! 
             }
         }
     }
@@ -214,20 +1539,24 @@ bool SixDegrees::dfs(const Artist &a, const Artist &b)
 }
 
 /*checkDFSBFS
- *arguments: 2 artists, a and b, output stream
+ *arguments: 2 artists, a and b, where to put their vertex IDs, output stream
  *Returns: boolean value 
  *Purpose: This functin checks if the artists are valid, and prints error
-           messages to output stream if not.
+           messages to output stream if not. Names are looked up with
+           findArtist, so they need not be spelled exactly.
  */
-bool SixDegrees::checkDFSBFS(const Artist &a, const Artist &b, ostream &output)
+bool SixDegrees::checkDFSBFS(const Artist &a, const Artist &b, size_t &from,
+                             size_t &to, ostream &output)
 {
     bool valid = true;
+    from = findArtist(a.get_name());
+    to = findArtist(b.get_name());
         
-    if (not graph.is_vertex(a)) { 
+    if (from == CollabGraph::NO_VERTEX) { 
         printBadArt(a.get_name(), output); //print bad name from getline
         valid = false;
     }
-    if (not graph.is_vertex(b)) {
+    if (to == CollabGraph::NO_VERTEX) {
         printBadArt(b.get_name(), output);
         valid = false; //invalid artists make this false
     }
@@ -236,47 +1565,76 @@ bool SixDegrees::checkDFSBFS(const Artist &a, const Artist &b, ostream &output)
     
 }
 
+/*findArtist
+ *Arguments: an artist name as the user typed it
+ *Returns: the artist's vertex ID, or NO_VERTEX if there is no such artist
+ *Purpose: The exact name first, then the same name but for case, accents,
+ *         apostrophes and punctuation (see NameIndex), so "beyonce" finds
+ *         "Beyoncé" and "Don't" finds "Don’t".
+ */
+size_t SixDegrees::findArtist(const string &name) const
+{
+    size_t id = graph.find_vertex(name);
+    if (id == CollabGraph::NO_VERTEX) id = names.find(name);
+    return id;
+}
+
 /*prepNot
  *Arguments: Input stream and output stream 
  *Returns: N/A
  *Purpose: This function takes as many artists from the input stream until 
  *         it finds "*" after at least 2 artists, to indicate exclusion from
- *         the search
+ *         the search. After the first two lines, "@name" excludes a whole
+ *         list registered with the exclusion command.
  */
 void SixDegrees::prepNot(istream &input, ostream &output) 
 {
-    graph.clear_metadata(); //clear the graph!
     string newArtist;    
     vector<Artist> exclusions;
+    vector<size_t> ids;
     
     //keep checking for more input, add to a vector
+    state.reset(graph.vertex_count()); //clear the marks!
     while (not getline(input, newArtist).fail() and (newArtist != "*")) {
+        auto list = exclusionLists.end();
+        if (exclusions.size() >= 2 and newArtist.size() > 1 and
+            newArtist[0] == '@') {
+            list = exclusionLists.find(newArtist.substr(1));
+        }
+        if (list != exclusionLists.end()) {
+            state.skip(list->second); //a whole list, no names to look up
+        } else {
             exclusions.push_back(Artist(newArtist)); //push to  vector
+        }
     }
     
     //check if the exclusions are valid
-    if (checkNot(exclusions, output)) {
+    if (checkNot(exclusions, ids, output)) {
         //mark vertices for all the correct exclusions!
-        for (size_t i = 2; i < exclusions.size(); i++) {
-            graph.mark_vertex(exclusions.at(i));
+        for (size_t i = 2; i < ids.size(); i++) {
+            state.mark(ids.at(i));
         }
-        bfs(exclusions.at(0), exclusions.at(1));
-        print(output, exclusions.at(0), exclusions.at(1));     
+        printOutcome(output, ids.at(0), ids.at(1),
+                     bfs(ids.at(0), ids.at(1), state, limits));
     } 
 }
 
 /*checkNot
- *Arguments: A vector of artists
+ *Arguments: A vector of artists, a vector to fill with their vertex IDs
  *Returns: boolean value
  *Purpose: This function is swag and determines whether or not the vector
            Passed in is valid or not. If not valid, prints the error message.
+           Each name is looked up once, and the IDs are handed back.
 */
-bool SixDegrees::checkNot(vector<Artist> check, ostream &output)
+bool SixDegrees::checkNot(const vector<Artist> &check, vector<size_t> &ids,
+                          ostream &output)
 {
     bool legit = true;
     //check for valid vertices
+    ids.clear();
     for (size_t i = 0; i < check.size(); i++) {
-        if (not graph.is_vertex(check.at(i))) {
+        ids.push_back(findArtist(check.at(i).get_name()));
+        if (ids.back() == CollabGraph::NO_VERTEX) {
             printBadArt(check.at(i).get_name(),output);
             legit = false;
         }
@@ -299,86 +1657,513 @@ bool SixDegrees::checkNot(vector<Artist> check, ostream &output)
     return legit;
 }
 
+/*prepExclusion
+ *Arguments: Input stream and output stream 
+ *Returns: N/A
+ *Purpose: Reads a list name and then artists up to "*", and registers them
+ *         as a named exclusion list that later not queries can use with
+ *         "@name". Registering a name again replaces the list. Nothing is
+ *         registered if any of the artists are not in the dataset.
+ */
+void SixDegrees::prepExclusion(istream &input, ostream &output)
+{
+    string name, newArtist;
+    getline(input, name);
+    vector<size_t> ids;
+    bool legit = true;
+    while (not getline(input, newArtist).fail() and (newArtist != "*")) {
+        ids.push_back(findArtist(newArtist));
+        if (ids.back() == CollabGraph::NO_VERTEX) {
+            printBadArt(newArtist, output);
+            legit = false;
+        }
+    }
+    
+    if (legit) {
+        size_t size = registerExclusion(name, ids);
+        output << "Exclusion list \"" << name << "\" has " << size
+               << " artist" << (size == 1 ? "" : "s") << "." << endl;
+    }
+}
+
+/*answerExclusion
+ *arguments: a parsed "exclusion" request and the output stream
+ *returns: N/A
+ *Purpose: The JSON side of prepExclusion: registers the "exclude" artists
+ *         under "name" and replies with the "size" of the list.
+ */
+void SixDegrees::answerExclusion(const Request &req, ostream &output) const
+{
+    if (req.get("name") == "") {
+        writeError(output, req.id, "\"name\" is required");
+        return;
+    }
+    
+    vector<string> names = req.get_list("exclude");
+    vector<string> missing;
+    vector<size_t> ids;
+    for (size_t i = 0; i < names.size(); i++) {
+        ids.push_back(findArtist(names.at(i)));
+        if (ids.back() == CollabGraph::NO_VERTEX) {
+            missing.push_back(names.at(i));
+        }
+    }
+    if (not missing.empty()) {
+        writeReply(output, req.id, "not_found");
+        output << ",\"names\":[";
+        for (size_t i = 0; i < missing.size(); i++) {
+            if (i > 0) output << ',';
+            write_json_string(output, missing.at(i));
+        }
+        output << "]}\n";
+        return;
+    }
+    
+    size_t size = registerExclusion(req.get("name"), ids);
+    writeReply(output, req.id, "ok");
+    output << ",\"size\":" << size << "}\n";
+}
+
+/*registerExclusion
+ *arguments: a list name and the vertex IDs on it
+ *returns: how many distinct artists are on the list
+ *Purpose: Builds the list's bitset and stores it under its name. Searches
+ *         that are using the old list hold listLock, so this waits for them.
+ */
+size_t SixDegrees::registerExclusion(const string &name,
+                                     const vector<size_t> &ids) const
+{
+    VertexSet list;
+    for (size_t i = 0; i < ids.size(); i++) {
+        list.insert(ids.at(i));
+    }
+    size_t size = list.size();
+    
+    unique_lock<shared_mutex> lists(listLock);
+    exclusionLists[name] = move(list);
+    return size;
+}
+
+/*prepSongFilter
+ *Arguments: Input stream and output stream 
+ *Returns: N/A
+ *Purpose: Reads a filter name and then song titles up to "*", and registers
+ *         them as a named song filter that avoid queries can use with
+ *         "@name". Works like prepExclusion, but for songs.
+ */
+void SixDegrees::prepSongFilter(istream &input, ostream &output)
+{
+    string name, title;
+    getline(input, name);
+    vector<size_t> ids;
+    bool legit = true;
+    while (not getline(input, title).fail() and (title != "*")) {
+        ids.push_back(graph.find_song(title));
+        if (ids.back() == CollabGraph::NO_SONG) {
+            printBadSong(title, output);
+            legit = false;
+        }
+    }
+    
+    if (legit) {
+        size_t size = registerSongFilter(name, ids);
+        output << "Song filter \"" << name << "\" has " << size
+               << " song" << (size == 1 ? "" : "s") << "." << endl;
+    }
+}
+
+/*prepAvoid
+ *Arguments: Input stream and output stream 
+ *Returns: N/A
+ *Purpose: Reads two artists and then song titles (or "@name" for a song
+ *         filter) up to "*", and prints the shortest path between the
+ *         artists that only goes through other songs. Two artists whose
+ *         songs together are all blocked are simply not linked.
+ */
+void SixDegrees::prepAvoid(istream &input, ostream &output)
+{
+    string source, dest, title;
+    getline(input, source); //read in source
+    getline(input, dest); //read in destination
+    Artist a(source);
+    Artist b(dest);
+    
+    state.reset(graph.vertex_count()); //clear the marks!
+    VertexSet avoid; //the songs named right here
+    bool legit = true;
+    while (not getline(input, title).fail() and (title != "*")) {
+        auto filter = songFilters.end();
+        if (title.size() > 1 and title[0] == '@') {
+            filter = songFilters.find(title.substr(1));
+        }
+        if (filter != songFilters.end()) {
+            state.block_songs(filter->second);
+        } else if (graph.find_song(title) != CollabGraph::NO_SONG) {
+            avoid.insert(graph.find_song(title));
+        } else {
+            printBadSong(title, output);
+            legit = false;
+        }
+    }
+    
+    size_t from, to;
+    if (checkDFSBFS(a, b, from, to, output) and legit) {
+        if (not avoid.empty()) state.block_songs(avoid);
+        printOutcome(output, from, to, bfs(from, to, state, limits));
+    }
+}
+
+/*answerSongFilter
+ *arguments: a parsed "songfilter" request and the output stream
+ *returns: N/A
+ *Purpose: The JSON side of prepSongFilter: registers the "songs" under
+ *         "name" and replies with the "size" of the filter.
+ */
+void SixDegrees::answerSongFilter(const Request &req, ostream &output) const
+{
+    if (req.get("name") == "") {
+        writeError(output, req.id, "\"name\" is required");
+        return;
+    }
+    
+    vector<string> titles = req.get_list("songs");
+    vector<size_t> ids;
+    for (size_t i = 0; i < titles.size(); i++) {
+        ids.push_back(graph.find_song(titles.at(i)));
+        if (ids.back() == CollabGraph::NO_SONG) {
+            writeError(output, req.id,
+                       "no song titled \"" + titles.at(i) + "\"");
+            return;
+        }
+    }
+    
+    size_t size = registerSongFilter(req.get("name"), ids);
+    writeReply(output, req.id, "ok");
+    output << ",\"size\":" << size << "}\n";
+}
+
+/*registerSongFilter
+ *arguments: a filter name and the song IDs in it
+ *returns: how many distinct songs are in the filter
+ *Purpose: Builds the filter's bitset over song IDs and stores it under its
+ *         name, under the same lock as the exclusion lists.
+ */
+size_t SixDegrees::registerSongFilter(const string &name,
+                                      const vector<size_t> &ids) const
+{
+    VertexSet filter;
+    for (size_t i = 0; i < ids.size(); i++) {
+        filter.insert(ids.at(i));
+    }
+    size_t size = filter.size();
+    
+    unique_lock<shared_mutex> lists(listLock);
+    songFilters[name] = move(filter);
+    return size;
+}
+
 /*print
- *Arguments: Output stream, 2 Artists; source and destination
+ *Arguments: Output stream, 2 vertex IDs; source and destination
  *Returns: none, just prints to output.
- *Purpose: This function uses the report_path function in CollabGraph
+ *Purpose: This function follows the predecessors in the search state
  *         to print the correct output for whenever BFS/DFS/NOT is called.
  */
-void SixDegrees::print(ostream &output, const Artist &a, const Artist &b)
+void SixDegrees::print(ostream &output, size_t a, size_t b)
 {
-    stack<Artist> path = graph.report_path(a,b); //get the path from a to b
+    vector<size_t> path = state.path(a, b); //get the path from a to b
     if (path.empty() or (a == b)) {
-        output << "A path does not exist between \"" << a.get_name()
-               << "\" and \"" << b.get_name() << "\"." << endl;
+        output << "A path does not exist between \"" << graph.get_name(a)
+               << "\" and \"" << graph.get_name(b) << "\"." << endl;
                return;
     }
     
-    while (not path.empty()) {
-        Artist temp = path.top();
-        path.pop();
-        if (not path.empty()) {
-            Artist before = path.top();
-            output <<  "\"" << temp.get_name() << "\" collaborated with \""
-                   << before << "\" in \"" 
-                   << graph.get_edge(temp,before) << "\"." << endl;
+    printPath(output, path);
+}
+
+/*printOutcome
+ *Arguments: Output stream, 2 vertex IDs and how bfs between them ended
+ *Returns: none, just prints to output.
+ *Purpose: print, unless the limits stopped the search before it could tell
+ *         whether there is a path, in which case it says which limit did
+ */
+void SixDegrees::printOutcome(ostream &output, size_t a, size_t b,
+                              Outcome outcome)
+{
+    if (outcome == Outcome::DEPTH_LIMIT) {
+        output << "A path does not exist between \"" << graph.get_name(a)
+               << "\" and \"" << graph.get_name(b) << "\" within "
+               << limits.depth << (limits.depth == 1 ? " hop." : " hops.")
+               << endl;
+    } else if (outcome == Outcome::OVER_BUDGET) {
+        output << "The search for a path between \"" << graph.get_name(a)
+               << "\" and \"" << graph.get_name(b)
+               << "\" ran out of budget." << endl;
+    } else {
+        print(output, a, b);
+    }
+}
+
+/*printPath
+ *Arguments: Output stream and a path of vertex IDs, source first
+ *Returns: none, just prints to output.
+ *Purpose: Prints one line per hop of a path, then "***"
+ */
+void SixDegrees::printPath(ostream &output, const vector<size_t> &path)
+{
+    for (size_t i = 0; i + 1 < path.size(); i++) {
+        size_t temp = path.at(i);
+        size_t before = path.at(i + 1);
+        output <<  "\"" << graph.get_name(temp) << "\" collaborated with \""
+               << graph.get_name(before) << "\" in ";
+        vector<size_t> songs = usableSongs(temp, before,
+                                           state.blocked_songs());
+        if (allSongs) {
+            printSongs(output, songs);
+        } else {
+            output << "\"" << graph.get_song(songs.at(0)) << "\"";
         }
+        output << "." << endl;
     }
     output << "***" << endl;
 }
 
+/*usableSongs
+ *Arguments: Two adjacent vertex IDs and the blocked songs (or nullptr)
+ *Returns: the song IDs of their edge that are not blocked, first song first
+ *Purpose: What print and writeHops may name as the song of a hop, so a
+ *         song-filtered path never credits a song it was told to avoid
+ */
+vector<size_t> SixDegrees::usableSongs(size_t a, size_t b,
+                                       const VertexSet *blocked) const
+{
+    vector<size_t> songs = graph.get_song_ids(a, b);
+    if (blocked == nullptr) return songs;
+    
+    vector<size_t> usable;
+    for (size_t i = 0; i < songs.size(); i++) {
+        if (not blocked->contains(songs.at(i))) usable.push_back(songs.at(i));
+    }
+    return usable;
+}
+
+/*blockedEdge
+ *Arguments: the edge a neighbor iterator is on, the search
+ *Returns: true if the search may not use that edge
+ *Purpose: The song filter test every search makes on every edge. With no
+ *         filter it is one pointer check; otherwise it looks for a song on
+ *         the edge that is not blocked (see CollabGraph::Neighbors).
+ */
+bool SixDegrees::blockedEdge(const CollabGraph::Neighbors &edge,
+                             const SearchState &search) const
+{
+    const VertexSet *blocked = search.blocked_songs();
+    return blocked != nullptr and
+           edge.open_song(*blocked) == CollabGraph::NO_SONG;
+}
+
+/*printSongs
+ *Arguments: Output stream and the song IDs of one edge
+ *Returns: none, just prints to output.
+ *Purpose: Lists every song of an edge for print, as "a", "b" and "c"
+ */
+void SixDegrees::printSongs(ostream &output, const vector<size_t> &songs)
+{
+    for (size_t i = 0; i < songs.size(); i++) {
+        if (i > 0) output << (i + 1 == songs.size() ? " and " : ", ");
+        output << "\"" << graph.get_song(songs.at(i)) << "\"";
+    }
+}
+
+/*renumber
+ *arguments: the vertex ordering to use
+ *returns: N/A
+ *Purpose: Renumbers the loaded graph so neighbors sit close together in
+ *         memory (see VertexOrder.h). Paths come out the same; only the
+ *         vertex IDs in JSON replies change.
+ */
+void SixDegrees::renumber(VertexOrder order)
+{
+    if (order == VertexOrder::FILE_ORDER) return; //already in file order
+    if (graph.is_mapped()) { //its order was picked when it was saved
+        cerr << "a graph file keeps the order it was built with" << endl;
+        exit(EXIT_FAILURE);
+    }
+    vector<size_t> newOrder = vertex_order(graph, order);
+    graph.renumber(newOrder);
+    
+    vector<size_t> newId(newOrder.size()); //keep places pointing right
+    for (size_t i = 0; i < newOrder.size(); i++) newId.at(newOrder.at(i)) = i;
+    for (size_t i = 0; i < places.size(); i++) {
+        places.at(i) = newId.at(places.at(i));
+    }
+    names.build(graph);
+}
+
+/*compress
+ *arguments: none
+ *returns: N/A
+ *Purpose: Switches the loaded graph to compressed adjacency lists (see
+ *         CollabGraph::compress). Searches answer exactly as before while
+ *         the edges take a fraction of the memory; call renumber first.
+ */
+void SixDegrees::compress()
+{
+    graph.compress();
+}
+
+/*save
+ *arguments: the name of the graph file to write
+ *returns: N/A
+ *Purpose: Compresses the graph and writes it where the constructor can map
+ *         it later, so big graphs are loaded and renumbered once and then
+ *         searched from the file. Exits if the file cannot be written.
+ */
+void SixDegrees::save(const string &path)
+{
+    graph.compress();
+    try {
+        graph.save(path);
+    } catch (const runtime_error &e) {
+        cerr << e.what() << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*export_to
+ *arguments: the name of the file to write and its format
+ *returns: N/A
+ *Purpose: Streams the graph out for other tools (see GraphExport), gzipped
+ *         if the name ends in ".gz". Exits if the file cannot be written.
+ */
+void SixDegrees::export_to(const string &path, GraphExport::Format format)
+{
+    try {
+        GraphExport::write(graph, format, path);
+    } catch (const runtime_error &e) {
+        cerr << e.what() << endl;
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*benchmark
+ *arguments: how many queries to run and the stream for the report
+ *returns: N/A
+ *Purpose: Times bfs between random pairs of artists. The pairs are picked
+ *         by their place in the data file with a fixed seed, so runs with
+ *         different --order settings time exactly the same searches. Run it
+ *         under "perf stat -e cache-misses" to see the cache side as well.
+ */
+void SixDegrees::benchmark(size_t queries, ostream &output)
+{
+    //a graph file has no data file to pick places in, so its artists are
+    //picked by vertex ID, which is the same thing for a file saved in
+    //file order
+    size_t count = places.empty() ? graph.vertex_count() : places.size();
+    if (count == 0) return;
+    auto artist = [&](size_t place) {
+        return places.empty() ? place : places.at(place);
+    };
+    mt19937 pick(2021);
+    uniform_int_distribution<size_t> any(0, count - 1);
+    vector<size_t> from, to;
+    for (size_t i = 0; i < queries; i++) {
+        from.push_back(artist(any(pick)));
+        to.push_back(artist(any(pick)));
+    }
+    
+    size_t found = 0, hops = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; i++) {
+        state.reset(graph.vertex_count());
+        if (bfs(from.at(i), to.at(i), state, limits) == Outcome::FOUND) {
+            found++;
+            hops += state.path(from.at(i), to.at(i)).size() - 1;
+        }
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() -
+                                                start).count();
+    
+    output << "bfs: " << queries << " queries over " << graph.vertex_count()
+           << " artists in " << ms << " ms (" << ms * 1000 / queries
+           << " us per query), " << found << " paths found, "
+           << (found == 0 ? 0.0 : (double) hops / found)
+           << " hops on average" << endl;
+}
+
+/*set_limits
+ *arguments: how far searches may go
+ *returns: N/A
+ *Purpose: Sets the depth, vertex and time limits of every bfs, not, avoid
+ *         and distances command, which JSON requests can override.
+ */
+void SixDegrees::set_limits(const Limits &searchLimits)
+{
+    limits = searchLimits;
+}
+
+/*set_threads
+ *arguments: how many threads a single search may use
+ *returns: N/A
+ *Purpose: Lets bfs, not, avoid and distances on a big graph search each
+ *         level in parallel (see traverse_parallel in Traversal.h). They
+ *         find exactly the same paths on any number of threads.
+ */
+void SixDegrees::set_threads(size_t count)
+{
+    threads = count == 0 ? 1 : count;
+}
+
+/*searchThreads
+ *arguments: none
+ *returns: how many threads the next search should use
+ *Purpose: One thread unless the graph is big enough for the parallel
+ *         search to pay for starting its threads.
+ */
+size_t SixDegrees::searchThreads() const
+{
+    return graph.vertex_count() >= PARALLEL_GRAPH ? threads : 1;
+}
+
+/*list_all_songs
+ *Arguments: true to list every song of each hop, false for just the first
+ *Returns: none
+ *Purpose: Lets main choose how print names the songs on a path
+ */
+void SixDegrees::list_all_songs(bool on)
+{
+    allSongs = on;
+}
+
 /*fillGraph 
- *arguments: input stream for the artists and songs 
+ *arguments: line reader for the artists and songs, and about how much
+ *           memory the load may use besides the graph
  *returns: N/A 
  *Purpose: This function is called from the constructor to insert edges and
- *         vertices for the graph.
+ *         vertices for the graph. Each record is handed to a GraphBuilder
+ *         as it is read and then forgotten, so no discography is ever held
+ *         in memory; the builder sorts who sang what (on disk, if it has
+ *         to) to find the edges.
  */
-void SixDegrees::fillGraph(istream &artFile) 
+void SixDegrees::fillGraph(LineReader &artFile, size_t loadMemory) 
 {
+    GraphBuilder builder(graph, loadMemory);
     bool makeNew = true;
-    string next;
-    while (not getline(artFile,next).fail()) {
+    string_view next;
+    while (artFile.next(next)) {
         if (next == "*") {//going to make new artist next 
             makeNew = true;
             
-        } else if (makeNew == true) { //made new artist add to vector
-            Artist tempArtist(next);
-            artistList.push_back(tempArtist);  //push back to the vector 
-            graph.insert_vertex(tempArtist); 
+        } else if (makeNew == true) { //a new artist's record starts here
+            builder.add_artist(next);
             makeNew = false; //set makeNew to false to prepare to read songs.
             
         //adding the songs for the artist baby! Woohoo!
         } else { 
-            artistList.back().add_song(next);
+            builder.add_song(next);
         }    
     }
     
-    //for loop to set each neighbor and set the edges.
-    fillneighbors(artistList);
-    
+    //now that every song is in, set each neighbor and set the edges.
+    builder.finish();
+    places = builder.places();
 }
-
-
-/*fillneighbors 
- *arguments: Vector of artists
- *Returns: none 
- *Purpose: This function finds the neighbors of each artists and marks the 
-           edges on the graph as such
-*/
-void SixDegrees::fillneighbors(vector<Artist> list) 
-{
-    for (size_t i = 0; i < list.size(); i++) {
-        Artist temp = list.at(i); //set artist to the current one.
-        
-        for (size_t i = 0; i < list.size(); i++) {
-            Artist collaborating = list.at(i);
-            //get collaboration between 2 artists
-            string collab = temp.get_collaboration(collaborating);
-            
-            //check if artists are same or if no collab
-            if ((temp != collaborating) and collab != "") {
-                graph.insert_edge(temp, collaborating, collab); //insert edge
-            }
-        }
-    }
-}
\ No newline at end of file
@@ -7,6 +7,20 @@
  * DFS (Depth-first-Search)
  * BFS (Breadth-first-search)
  * Not (exclusion of artists, but still BFS)
+ * Strongest (path along the strongest collaborations, Dijkstra)
+ * Allpaths (every shortest path, or the first few, between two artists)
+ * Exclusion (register a named list of artists for not to leave out)
+ * Avoid (BFS that may not go through the given songs or song filters)
+ * Songfilter (register a named list of songs for avoid to leave out)
+ * Distances (how many artists are each number of hops from one artist)
+ * Centrality (the top artists by degree, closeness and betweenness)
+ * Within (every artist a few hops from one artist, as they are found)
+ * Nearest (the shortest path from any of some artists to any of others)
+ * Suggest (artist names like what was typed, for autocomplete)
+ * Stats (counts, degrees, components and memory use of the graph)
+ * Artist names are matched forgivingly: case, accents, apostrophes and
+ * punctuation do not have to be exactly right (see NameIndex.h)
+ * The same commands can also be sent as one JSON object per line
  *
  *April 19th 2021
  */
@@ -20,31 +34,156 @@
  #include <queue> 
  #include <string>
  #include <fstream>
+ #include <functional>
+ #include <cstdint>
+ #include <unordered_map>
+ #include <shared_mutex>
  
  #include "Artist.h" 
  #include "CollabGraph.h"
+ #include "Protocol.h"
+ #include "VertexSet.h"
+ #include "VertexOrder.h"
+ #include "LineReader.h"
+ #include "GraphBuilder.h"
+ #include "Traversal.h"
+ #include "NameIndex.h"
+ #include "GraphStats.h"
+ #include "GraphExport.h"
  
  class SixDegrees {
  public:
-     SixDegrees(std::string filename);
+     SixDegrees(std::string filename,
+                size_t loadMemory = GraphBuilder::DEFAULT_MEMORY,
+                bool normalize = false);
      ~SixDegrees();
+     SixDegrees(SixDegrees &&source);
+     SixDegrees &operator=(SixDegrees &&rhs);
      void play(std::istream &input, std::ostream &output);
+     void play_json(std::istream &input, std::ostream &output);
+     bool answer_line(const std::string &line, SearchState &search,
+                      std::ostream &output) const;
+     void list_all_songs(bool on);
+     void set_limits(const Limits &searchLimits);
+     void set_threads(size_t count);
+     void renumber(VertexOrder order);
+     void compress();
+     void save(const std::string &path);
+     void export_to(const std::string &path, GraphExport::Format format);
+     void benchmark(size_t queries, std::ostream &output);
      
  private:
      CollabGraph graph; 
-     std::vector<Artist> artistList;
-     void fillGraph(std::istream &artFile); 
-     bool checkDFSBFS(const Artist &a, const Artist &b, std::ostream &output);
+     SearchState state; //marks and predecessors for play/play_json
+     bool allSongs; //print every shared song instead of the first
+     Limits limits; //how far the breadth-first commands may go
+     size_t threads; //how many threads one bfs or distances may use
+     //graphs with fewer artists are always searched on one thread
+     static const size_t PARALLEL_GRAPH = 100000;
+     size_t searchThreads() const;
+     std::vector<size_t> places; //vertex ID of each data file artist record
+     NameIndex names; //artists by forgiving names; rebuilt by renumber
+     //named exclusion lists; answer() registers them from any thread
+     mutable std::unordered_map<std::string, VertexSet> exclusionLists;
+     mutable std::unordered_map<std::string, VertexSet> songFilters;
+     mutable std::shared_mutex listLock;
+     void fillGraph(LineReader &artFile, size_t loadMemory); 
+     size_t findArtist(const std::string &name) const;
+     bool checkDFSBFS(const Artist &a, const Artist &b, size_t &from,
+                      size_t &to, std::ostream &output);
      void printBadArt(std::string name, std::ostream &output);
-     void fillneighbors(std::vector<Artist> list);
+     void printBadSong(std::string title, std::ostream &output);
      void prepBFS(std::istream &input, std::ostream &output);
      void prepDFS(std::istream &input, std::ostream &output);
      void prepNot(std::istream &input, std::ostream &output);
-     bool checkNot(std::vector<Artist> check, std::ostream &output);
-     bool bfs(const Artist &a, const Artist &b);
-     void print(std::ostream &output, const Artist &a, const Artist &b);
-     bool dfs(const Artist &a, const Artist &b);
+     bool checkNot(const std::vector<Artist> &check, std::vector<size_t> &ids,
+                   std::ostream &output);
+     void prepExclusion(std::istream &input, std::ostream &output);
+     void answerExclusion(const Request &req, std::ostream &output) const;
+     size_t registerExclusion(const std::string &name,
+                              const std::vector<size_t> &ids) const;
+     void prepSongFilter(std::istream &input, std::ostream &output);
+     void prepAvoid(std::istream &input, std::ostream &output);
+     void answerSongFilter(const Request &req, std::ostream &output) const;
+     size_t registerSongFilter(const std::string &name,
+                               const std::vector<size_t> &ids) const;
+     bool blockedEdge(const CollabGraph::Neighbors &edge,
+                      const SearchState &search) const;
+     std::vector<size_t> usableSongs(size_t a, size_t b,
+                                     const VertexSet *blocked) const;
+     Outcome bfs(size_t a, size_t b, SearchState &search,
+                 const Limits &bfsLimits = Limits()) const;
+     void prepDistances(std::istream &input, std::ostream &output);
+     Outcome distances(size_t a, const Limits &bfsLimits,
+                       SearchState &search,
+                       std::vector<size_t> &levels) const;
+     /* one artist a within search reached, and the hop it was found by */
+     struct Nearby {
+         size_t artist;
+         size_t via;     /* the artist one hop closer */
+         size_t song;    /* a song the two share */
+         size_t hops;
+         size_t degree;
+     };
+     void prepWithin(std::istream &input, std::ostream &output);
+     Outcome within(size_t a, const Limits &bfsLimits, size_t top,
+                    SearchState &search,
+                    const std::function<void(const Nearby &)> &emit) const;
+     void prepNearest(std::istream &input, std::ostream &output);
+     Outcome nearest(const std::vector<size_t> &sources,
+                     const VertexSet &targets, const Limits &bfsLimits,
+                     SearchState &search, std::vector<size_t> &path) const;
+     void prepSuggest(std::istream &input, std::ostream &output);
+     void answerSuggest(const Request &req, std::ostream &output) const;
+     void prepCentrality(std::istream &input, std::ostream &output);
+     void answerCentrality(const Request &req, std::ostream &output) const;
+     /* one line of the stats command's memory breakdown */
+     struct Usage {
+         const char *key;    /* its name in JSON */
+         const char *label;  /* its name in text */
+         size_t bytes;
+     };
+     std::vector<Usage> memoryUsage(const SearchState &search) const;
+     void prepStats(std::ostream &output);
+     void answerStats(const Request &req, const SearchState &search,
+                      std::ostream &output) const;
+     bool readLimits(const Request &req, Limits &reqLimits,
+                     std::ostream &output) const;
+     void print(std::ostream &output, size_t a, size_t b);
+     void printOutcome(std::ostream &output, size_t a, size_t b,
+                       Outcome outcome);
+     void printPath(std::ostream &output, const std::vector<size_t> &path);
+     void printSongs(std::ostream &output, const std::vector<size_t> &songs);
+     bool dfs(size_t a, size_t b, SearchState &search) const;
+     void prepStrongest(std::istream &input, std::ostream &output);
+     bool strongest(size_t a, size_t b, SearchState &search) const;
+     void prepAllPaths(std::istream &input, std::ostream &output);
+     uint64_t countPaths(size_t a, size_t b, SearchState &search) const;
+     size_t walkPaths(size_t a, size_t b, size_t limit,
+                      const SearchState &search,
+                      const std::function<void(const std::vector<size_t> &)>
+                          &emit) const;
      Artist artistLookup(std::string name);
+     void answer(const Request &req, SearchState &search,
+                 std::ostream &output) const;
+     void writeReply(std::ostream &output, const std::string &id,
+                     const std::string &status) const;
+     void writeError(std::ostream &output, const std::string &id,
+                     const std::string &message) const;
+     void writePath(std::ostream &output, const std::string &id,
+                    const std::vector<size_t> &path,
+                    bool strengths, bool songs,
+                    const VertexSet *blocked) const;
+     void writeHops(std::ostream &output, const std::vector<size_t> &path,
+                    bool strengths, bool songs,
+                    const VertexSet *blocked) const;
+     void writeAllPaths(std::ostream &output, const Request &req, size_t a,
+                        size_t b, SearchState &search) const;
+     void writeDistances(std::ostream &output, const Request &req, size_t a,
+                         const Limits &reqLimits,
+                         SearchState &search) const;
+     void writeWithin(std::ostream &output, const Request &req, size_t a,
+                      const Limits &reqLimits, SearchState &search) const;
      
      
  };
@@ -0,0 +1,208 @@
+/**
+ ** Arena.cpp
+ **
+ ** Purpose:
+ **   A monotonic arena for the collaboration graph.
+ **   See Arena.h
+ **
+ **/
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "Arena.h"
+
+using namespace std;
+
+const size_t Arena::BLOCK_SIZE;
+const size_t Arena::HEADER;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: nullary constructor
+ * @purpose: initialize an empty arena; no memory is taken until the first
+ *           allocation
+ */
+Arena::Arena()
+{
+    blocks = nullptr;
+    cursor = nullptr;
+    limit = nullptr;
+    used = 0;
+    reserved = 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: destructor
+ * @purpose: give every block back
+ */
+Arena::~Arena()
+{
+    release();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * copy_string
+ * purpose: keep a copy of some text in the arena
+ *
+ * parameters: the text to copy
+ * returns: a view of the copy, valid until release()
+ */
+string_view Arena::copy_string(string_view text)
+{
+    if (text.empty()) return string_view();
+
+    char *copy = static_cast<char *>(allocate(text.size(), 1));
+    memcpy(copy, text.data(), text.size());
+    return string_view(copy, text.size());
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * release
+ * purpose: give back every block at once; everything made in the arena is
+ *          gone afterwards
+ *
+ * parameters: none
+ * returns: none
+ */
+void Arena::release()
+{
+    while (blocks != nullptr) {
+        Block *next = blocks->next;
+        free(blocks);
+        blocks = next;
+    }
+    cursor = nullptr;
+    limit = nullptr;
+    used = 0;
+    reserved = 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * bytes_used / bytes_reserved
+ * purpose: report how much of the arena has been handed out, and how much
+ *          it has taken from the system
+ */
+size_t Arena::bytes_used() const
+{
+    return used;
+}
+
+size_t Arena::bytes_reserved() const
+{
+    return reserved;
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * do_allocate
+ * purpose: carve 'bytes' from the newest block, starting a new block when it
+ *          is full. A large request gets a block of its own, so it does not
+ *          cut short the block that small requests are filling.
+ *
+ * notes: throws bad_alloc if the system is out of memory
+ */
+void *Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    if (bytes + alignment > BLOCK_SIZE / 4) {
+        char *start = new_block(bytes + alignment, blocks != nullptr);
+        used += bytes;
+        return align(start, alignment);
+    }
+
+    char *aligned = cursor == nullptr ? nullptr : align(cursor, alignment);
+    if (aligned == nullptr or aligned + bytes > limit) {
+        cursor = new_block(BLOCK_SIZE, false);
+        limit = cursor + BLOCK_SIZE;
+        aligned = align(cursor, alignment);
+    }
+
+    cursor = aligned + bytes;
+    used += bytes;
+    return aligned;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * new_block
+ * purpose: take a block of 'size' usable bytes from the system and link it
+ *          in, either as the newest block or (for a large request, when
+ *          'behind' is true) just behind it, leaving the newest block open
+ *
+ * returns: the first usable byte of the block
+ */
+char *Arena::new_block(size_t size, bool behind)
+{
+    Block *block = static_cast<Block *>(malloc(HEADER + size));
+    if (block == nullptr) throw bad_alloc();
+
+    block->size = size;
+    if (behind) {
+        block->next = blocks->next;
+        blocks->next = block;
+    } else {
+        block->next = blocks;
+        blocks = block;
+    }
+    reserved += HEADER + size;
+    return reinterpret_cast<char *>(block) + HEADER;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * align
+ * purpose: round a pointer up to a multiple of 'alignment' (a power of two)
+ */
+char *Arena::align(char *at, size_t alignment)
+{
+    uintptr_t bits = reinterpret_cast<uintptr_t>(at);
+    bits = (bits + alignment - 1) & ~(uintptr_t) (alignment - 1);
+    return reinterpret_cast<char *>(bits);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * do_deallocate
+ * purpose: nothing; the memory comes back with release()
+ */
+void Arena::do_deallocate(void *, size_t, size_t)
+{
+
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * do_is_equal
+ * purpose: two arenas can only free each other's memory if they are the
+ *          same arena
+ */
+bool Arena::do_is_equal(const memory_resource &other) const noexcept
+{
+    return this == &other;
+}
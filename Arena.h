@@ -0,0 +1,82 @@
+/**
+ ** Arena.h
+ **
+ ** Purpose:
+ **   A monotonic arena: memory is carved from large blocks one request after
+ **   another and is only ever given back all at once. CollabGraph keeps its
+ **   vertices, adjacency lists, artist names and song titles in one, so
+ **   loading a graph costs a handful of block allocations instead of one
+ **   per artist, and tearing it down is a single release().
+ **
+ ** Notes:
+ **   1) it is a std::pmr::memory_resource, so standard containers can grow
+ **      inside it; deallocate does nothing, and a vector that outgrows its
+ **      buffer leaves the old one behind until release()
+ **   2) objects made in the arena never have their destructors run, so only
+ **      objects whose memory all comes from the same arena belong in it
+ **   3) an arena cannot be copied; copying a graph means building the
+ **      copy's contents in the copy's own arena
+ **
+ **/
+
+#ifndef __ARENA__
+#define __ARENA__
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+
+class Arena : public std::pmr::memory_resource {
+
+public:
+    Arena();
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /* Mutators */
+    std::string_view copy_string(std::string_view text);
+    void             release();
+
+    template <typename T, typename... Args>
+    T *make(Args &&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+    }
+
+    /* Accessors */
+    size_t bytes_used() const;
+    size_t bytes_reserved() const;
+
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    /* each block starts with this header, followed by its bytes */
+    struct Block {
+        Block *next;
+        size_t size;
+    };
+    static const size_t HEADER = (sizeof(Block) + alignof(std::max_align_t) -
+                                  1) & ~(alignof(std::max_align_t) - 1);
+
+    char        *new_block(size_t size, bool behind);
+    static char *align(char *at, size_t alignment);
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void  do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool  do_is_equal(const std::pmr::memory_resource &other) const
+        noexcept override;
+
+    Block *blocks;      /* newest first */
+    char  *cursor;      /* next free byte in the newest block */
+    char  *limit;       /* one past the newest block's last byte */
+    size_t used;
+    size_t reserved;
+};
+
+#endif /* __ARENA__ */
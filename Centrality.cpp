@@ -0,0 +1,222 @@
+/**
+ ** Centrality.cpp
+ **
+ ** Purpose:
+ **   Degree, closeness and betweenness centrality of a CollabGraph.
+ **   See Centrality.h
+ **
+ **/
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+#include "Centrality.h"
+
+using namespace std;
+
+const uint32_t Centrality::UNREACHED;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: constructor
+ * @purpose: compute closeness and betweenness for every artist
+ *
+ * @parameters: 1) the graph, which must outlive this object
+ *              2) how many sources to search; 0, or at least the number
+ *                 of artists, searches from every artist for exact scores
+ *              3) how many threads to search on
+ */
+Centrality::Centrality(const CollabGraph &g, size_t samples, size_t threads)
+    : graph(g)
+{
+    size_t count = graph.vertex_count();
+    closeness.assign(count, 0);
+    betweenness.assign(count, 0);
+    if (count == 0) return;
+
+    vector<size_t> all(count);
+    for (size_t i = 0; i < count; i++) all[i] = i;
+    if (samples == 0 or samples >= count) {
+        picked = all;
+    } else {
+        mt19937 pick(2021);
+        sample(all.begin(), all.end(), back_inserter(picked), samples, pick);
+    }
+    if (threads == 0) threads = 1;
+    threads = min(threads, picked.size());
+
+    //source i is searched by worker i % threads, so the sums each worker
+    //makes, and the order they are added in, do not depend on timing
+    vector<Worker> workers(threads);
+    auto work = [&](size_t w) {
+        Worker &mine = workers[w];
+        mine.distance.assign(count, UNREACHED);
+        mine.paths.assign(count, 0);
+        mine.dependency.assign(count, 0);
+        mine.closeness.assign(count, 0);
+        mine.betweenness.assign(count, 0);
+        for (size_t i = w; i < picked.size(); i += threads) {
+            brandes(picked[i], mine);
+        }
+    };
+    vector<thread> helpers;
+    for (size_t w = 1; w < threads; w++) helpers.emplace_back(work, w);
+    work(0);
+    for (size_t i = 0; i < helpers.size(); i++) helpers[i].join();
+
+    //scale the sample's sums up to every source; each pair of artists is
+    //counted from both ends, so betweenness is halved
+    double scale = (double) count / picked.size();
+    double others = count > 1 ? count - 1 : 1;
+    for (size_t w = 0; w < workers.size(); w++) {
+        for (size_t v = 0; v < count; v++) {
+            closeness[v] += workers[w].closeness[v];
+            betweenness[v] += workers[w].betweenness[v];
+        }
+        workers[w] = Worker(); //free as we go
+    }
+    for (size_t v = 0; v < count; v++) {
+        closeness[v] *= scale / others;
+        betweenness[v] *= scale / 2;
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * top_degree / top_closeness / top_betweenness
+ * purpose: rank the artists by one measure
+ *
+ * parameters: how many artists to return
+ * returns:    the best 'count' artists and their scores, best first
+ */
+vector<Centrality::Score> Centrality::top_degree(size_t count) const
+{
+    vector<double> degrees(graph.vertex_count());
+    for (size_t v = 0; v < degrees.size(); v++) degrees[v] = graph.degree(v);
+    return top(degrees, count);
+}
+
+vector<Centrality::Score> Centrality::top_closeness(size_t count) const
+{
+    return top(closeness, count);
+}
+
+vector<Centrality::Score> Centrality::top_betweenness(size_t count) const
+{
+    return top(betweenness, count);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * sources
+ * purpose: report how much of the graph the estimates come from
+ *
+ * parameters: none
+ * returns:    how many artists were searched from
+ */
+size_t Centrality::sources() const
+{
+    return picked.size();
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * brandes
+ * purpose: add one source's share to a worker's closeness and betweenness
+ *          sums
+ *
+ * parameters: the source and the worker, whose distances must all be
+ *             UNREACHED; they are again when it returns
+ * returns:    none
+ *
+ * notes: the search counts shortest paths forwards, then walks back in
+ *        reverse order, where every artist's dependency is complete before
+ *        the artists one hop closer to the source add it in. Predecessors
+ *        are found again by their distance instead of being stored.
+ */
+void Centrality::brandes(size_t source, Worker &work) const
+{
+    vector<size_t> &order = work.order;
+    order.clear();
+    order.push_back(source);
+    work.distance[source] = 0;
+    work.paths[source] = 1;
+    work.dependency[source] = 0;
+
+    for (size_t head = 0; head < order.size(); head++) {
+        size_t vertex = order[head];
+        uint32_t next = work.distance[vertex] + 1;
+        CollabGraph::Neighbors edge = graph.neighbors(vertex);
+        while (edge.next()) {
+            size_t other = edge.neighbor();
+            if (work.distance[other] == UNREACHED) {
+                work.distance[other] = next;
+                work.paths[other] = 0;
+                work.dependency[other] = 0;
+                order.push_back(other);
+                work.closeness[other] += 1.0 / next;
+            }
+            if (work.distance[other] == next) {
+                work.paths[other] += work.paths[vertex];
+            }
+        }
+    }
+
+    for (size_t i = order.size(); i-- > 1; ) {
+        size_t vertex = order[i];
+        uint32_t before = work.distance[vertex] - 1;
+        double share = (1 + work.dependency[vertex]) / work.paths[vertex];
+        CollabGraph::Neighbors edge = graph.neighbors(vertex);
+        while (edge.next()) {
+            size_t other = edge.neighbor();
+            if (work.distance[other] == before) {
+                work.dependency[other] += work.paths[other] * share;
+            }
+        }
+        work.betweenness[vertex] += work.dependency[vertex];
+    }
+
+    for (size_t i = 0; i < order.size(); i++) {
+        work.distance[order[i]] = UNREACHED;
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * top
+ * purpose: pick the highest scores without sorting them all
+ *
+ * parameters: a score per vertex ID and how many to pick
+ * returns:    the best 'count', best first, ties broken by lower vertex ID
+ */
+vector<Centrality::Score> Centrality::top(const vector<double> &scores,
+                                          size_t count)
+{
+    vector<Score> ranked(scores.size());
+    for (size_t v = 0; v < scores.size(); v++) ranked[v] = Score{v, scores[v]};
+    count = min(count, ranked.size());
+    partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                 [](const Score &a, const Score &b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.id < b.id;
+    });
+    ranked.resize(count);
+    return ranked;
+}
@@ -0,0 +1,81 @@
+/**
+ ** Centrality.h
+ **
+ ** Purpose:
+ **   Which artists hold the collaboration graph together. Three measures
+ **   are ranked:
+ **     - degree:      how many artists one has worked with
+ **     - closeness:   harmonic closeness, the average of 1 / distance to
+ **                    every other artist (0 for artists it cannot reach)
+ **     - betweenness: on how many shortest paths between two other
+ **                    artists one lies, shared out when there are several
+ **
+ **   Closeness and betweenness both come from Brandes' algorithm: one
+ **   breadth-first search per source counts the shortest paths to every
+ **   artist, and walking the search back in reverse order adds up how much
+ **   each artist's paths depend on the others. On a big graph only a
+ **   random sample of sources is searched and the sums are scaled up,
+ **   which estimates both measures for every artist at once.
+ **
+ ** Notes:
+ **   1) the searches are split over threads by source, each thread keeping
+ **      its own counts and sums, which are added together in thread order
+ **      at the end; the scores are the same from run to run for the same
+ **      number of threads
+ **   2) the sample is drawn with a fixed seed, so the same graph and sample
+ **      size always search the same sources
+ **   3) betweenness counts each pair of artists once (the graph is
+ **      undirected); closeness is between 0 and 1
+ **   4) memory is about 40 bytes per artist per thread
+ **
+ **/
+
+#ifndef __CENTRALITY__
+#define __CENTRALITY__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CollabGraph.h"
+
+class Centrality {
+
+public:
+    struct Score {
+        size_t id;
+        double score;
+    };
+
+    Centrality(const CollabGraph &graph, size_t samples, size_t threads);
+
+    /* Accessors: the 'count' best artists, best first, ties by vertex ID */
+    std::vector<Score> top_degree(size_t count) const;
+    std::vector<Score> top_closeness(size_t count) const;
+    std::vector<Score> top_betweenness(size_t count) const;
+    size_t             sources() const;
+
+private:
+    static const uint32_t UNREACHED = (uint32_t) -1;
+
+    /* one thread's working arrays and running sums */
+    struct Worker {
+        std::vector<uint32_t> distance;
+        std::vector<double>   paths;        /* shortest paths from source */
+        std::vector<double>   dependency;
+        std::vector<size_t>   order;        /* vertices in search order */
+        std::vector<double>   closeness;
+        std::vector<double>   betweenness;
+    };
+
+    void brandes(size_t source, Worker &work) const;
+    static std::vector<Score> top(const std::vector<double> &scores,
+                                  size_t count);
+
+    const CollabGraph  &graph;
+    std::vector<size_t> picked;     /* the sources searched */
+    std::vector<double> closeness;
+    std::vector<double> betweenness;
+};
+
+#endif /* __CENTRALITY__ */
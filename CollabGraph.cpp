@@ -24,12 +24,20 @@
 #include <unordered_map>
 #include <functional>
 #include <exception>
+#include <algorithm>
+#include <memory>
+#include <utility>
 
 #include "Artist.h"
 #include "CollabGraph.h"
+#include "GraphFile.h"
+#include "NameFold.h"
 
 using namespace std;
 
+const size_t CollabGraph::NO_VERTEX;
+const size_t CollabGraph::NO_SONG;
+
 /*********************************************************************
  ******************** public function definitions ********************
  *********************************************************************/
@@ -46,7 +54,8 @@ using namespace std;
  */
 CollabGraph::CollabGraph()
 {
-    
+    arena = make_unique<Arena>();
+    make_maps();
 }
 
 
@@ -59,10 +68,14 @@ CollabGraph::CollabGraph()
  * @preconditions: none
  * @postconditions: all heap-allocated memory associated with this CollabGraph
  *                  instace is freed
+ *
+ * @notes: nothing is visited vertex by vertex: the members' destructors
+ *         free the ID tables and arrays, and the arena's frees its blocks,
+ *         with the vertices, names and maps in them
  */
 CollabGraph::~CollabGraph()
 {
-    self_destruct();
+
 }
 
 
@@ -73,13 +86,13 @@ CollabGraph::~CollabGraph()
  *
  * @preconditions: none
  * @postconditions: this instance is a deep copy of the provided
- *                  CollabGraph reference
+ *                  CollabGraph reference, with the same vertex and song IDs
  *
  * @parameters: a const CollabGraph reference, to be deeply copied
  */
-CollabGraph::CollabGraph(const CollabGraph &source)
+CollabGraph::CollabGraph(const CollabGraph &source) : CollabGraph()
 {
-    *this = source;
+    copy_from(source);
 }
 
 
@@ -90,35 +103,113 @@ CollabGraph::CollabGraph(const CollabGraph &source)
  *
  * parameters: a const CollabGraph reference, to be deeply copied
  * returns: a CollabGraph reference
+ *
+ * notes: see copy_from; the marks and predecessors are not copied
  */
 CollabGraph &CollabGraph::operator=(const CollabGraph &rhs)
 {
     if (this == &rhs) return *this;
 
     self_destruct();
+    copy_from(rhs);
+    return *this;
+}
 
-    /* ITERATING OVER AN UNORDERED_MAP:
-     * An unordered map is made up of (key, value) pairs, of type std::pair.
-     * We use a std::iterator to iterate over the entire map, which starts
-     * out as the result of the unordered_map begin() function.
-     * 
-     * Declaring iterator types in C++ is pretty complicated, so this is
-     * the one case in which our course style guide allows for the use of
-     * the "auto" keyword.
-     */
-    for (auto itr = rhs.graph.begin(); itr != graph.end(); itr++) {
 
-        Vertex *vertexCopy = new Vertex;
-        vertexCopy->artist      = itr->second->artist;
-        vertexCopy->neighbors   = itr->second->neighbors;
-        vertexCopy->predecessor = itr->second->predecessor;
-        vertexCopy->visited     = itr->second->visited;
 
-        graph.insert({vertexCopy->artist.get_name(), vertexCopy});
-    }
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: move constructor
+ * @purpose: take over another CollabGraph instance's contents without
+ *           copying them
+ *
+ * @preconditions: no other thread is using 'source'
+ * @postconditions: this instance has everything 'source' had, with the
+ *                  same IDs; 'source' is an empty graph
+ *
+ * @parameters: the CollabGraph to take the contents of
+ */
+CollabGraph::CollabGraph(CollabGraph &&source) : CollabGraph()
+{
+    *this = std::move(source);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * move assignment operator overload
+ * purpose: swap in another graph's contents in constant time
+ *
+ * parameters: the CollabGraph to take the contents of
+ * returns: a CollabGraph reference
+ *
+ * notes: 1) the two graphs trade contents: 'rhs' is left holding what this
+ *           graph held, and frees it when it is destroyed or assigned, so
+ *           a graph being served can be replaced by a freshly built one
+ *           without the old one being freed in the middle of the swap
+ *        2) the arena is on the heap and the maps are made in it, so
+ *           trading them is trading pointers; vertex pointers, names and
+ *           adjacency lists stay where they are
+ */
+CollabGraph &CollabGraph::operator=(CollabGraph &&rhs)
+{
+    if (this == &rhs) return *this;
 
+    swap(arena, rhs.arena);
+    swap(graph, rhs.graph);
+    vertices.swap(rhs.vertices);
+    songs.swap(rhs.songs);
+    swap(songIds, rhs.songIds);
+    songPool.swap(rhs.songPool);
+    swap(normalized, rhs.normalized);
+    swap(compressed, rhs.compressed);
+    packed.swap(rhs.packed);
+    packedStart.swap(rhs.packedStart);
+    file.swap(rhs.file);
+    base.swap(rhs.base);
+    borrowed.swap(rhs.borrowed);
+    swap(borrowedSongs, rhs.borrowedSongs);
+    swap(metadata, rhs.metadata);
     return *this;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: fork constructor
+ * @purpose: make a graph that starts out the same as 'source' but shares
+ *           its memory until it is changed (see note 12 in CollabGraph.h)
+ *
+ * @preconditions: 'source' does not change while the fork is alive; the
+ *                 fork keeps it alive
+ * @postconditions: this instance has the vertices, edges and songs of
+ *                  'source', with the same IDs
+ *
+ * @parameters: the graph to fork, which may itself be a fork
+ *
+ * @notes: 1) costs a copy of the vertex pointers, the title views and the
+ *            song pool, which is a small part of the graph; the rest is
+ *            copied a vertex at a time as edges change (see own)
+ *         2) throws a runtime_error if 'source' is null, compressed or
+ *            mapped: those graphs cannot gain edges, so a fork would be no
+ *            different from sharing the graph itself
+ */
+CollabGraph::CollabGraph(shared_ptr<const CollabGraph> source)
+    : CollabGraph()
+{
+    if (source == nullptr or source->compressed) {
+        string message = "only a graph whose edges can still change can be "
+                         "forked";
+        throw runtime_error(message.c_str());
+    }
 
+    base = source;
+    normalized = source->normalized;
+    vertices = source->vertices;
+    borrowed.assign(vertices.size(), true);
+    songs = source->songs;
+    borrowedSongs = songs.size();
+    songPool = source->songPool;
+    metadata.resize(vertices.size());
 }
 
 
@@ -137,6 +228,7 @@ CollabGraph &CollabGraph::operator=(const CollabGraph &rhs)
  */
 void CollabGraph::insert_vertex(const Artist &artist)
 {
+    enforce_unmapped();
     if (artist.get_name() == "") {
         string message = "cannot insert an improperly initialized "
                               "Artist instance (name must be non-empty)";
@@ -150,12 +242,22 @@ void CollabGraph::insert_vertex(const Artist &artist)
      * management simpler.
      * 
      * Storing vertex pointers in the map rather than vertices makes keeping
-     * track of predecessors simpler.
+     * track of predecessors simpler. The vertex and its name are carved
+     * from the arena, and the map's key is the vertex's own copy (or its
+     * normal form, see normalize_names).
      */
     if (not is_vertex(artist)) {
-        Vertex *vertex = new Vertex(artist);
+        string_view name = arena->copy_string(artist.get_name());
+        Vertex *vertex = arena->make<Vertex>(name, arena.get());
+        vertex->id = vertices.size();
+        vertices.push_back(vertex);
+        metadata.resize(vertices.size());
+        if (compressed) { //a new vertex has no edges to encode
+            packedStart.push_back(packed.size());
+            write_varint(packed, 0);
+        }
         /* these curly braces make an initializer list for the pair struct */
-        graph.insert({artist.get_name(), vertex});
+        graph->insert({stored_key(name), vertex});
     }
 }
 
@@ -167,8 +269,9 @@ void CollabGraph::insert_vertex(const Artist &artist)
  *
  * preconditions: 1) both 'a1' and 'a2' are vertices in the graph
  * postconditions: an edge with name 'edgeName' is inserted between 'a1' and
- *                  'a2' iff there was not already an edge connecting those
- *                  vertices
+ *                  'a2' if there was not already an edge connecting those
+ *                  vertices; otherwise 'edgeName' is added to the songs of
+ *                  that edge (if it is not one of them already)
  *
  * parameters: 1) a const Artist reference, which should be a vertex in 
  *                the graph
@@ -203,13 +306,293 @@ void CollabGraph::insert_edge(const Artist &a1, const Artist &a2,
         throw runtime_error(message.c_str());
     }
 
-    /* Do not insert an edge between a1 and a2 if there
-     * is already an edge that connects them.
-     */
-    if (get_edge(a1, a2) != "") return;
+    vector<size_t> song(1, intern_song(edgeName));
+    insert_edge(get_vertex_id(a1), get_vertex_id(a2), song);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * insert_edge (by vertex and song ID)
+ * purpose: insert an edge carrying several songs between two vertices
+ *
+ * postconditions: the edge between 'id1' and 'id2' holds every song in
+ *                  'songList' (in order, after any songs it already held)
+ *
+ * parameters: 1) a vertex ID
+ *             2) a different vertex ID
+ *             3) the song IDs (from intern_song) the two artists share
+ * returns:    none
+ *
+ * notes: throws a runtime_error if the IDs are not vertices, are the same
+ *        vertex, if 'songList' is empty or if the graph is compressed
+ */
+void CollabGraph::insert_edge(size_t id1, size_t id2,
+                              const vector<size_t> &songList)
+{
+    enforce_valid_id(id1);
+    enforce_valid_id(id2);
+    enforce_uncompressed();
+
+    if (songList.empty()) {
+        string message = "an edge needs at least one song";
+        throw runtime_error(message.c_str());
+    }
+
+    if (id1 == id2) {
+        string message = "cannot insert an edge between a "
+                              "vertex and itself";
+        throw runtime_error(message.c_str());
+    }
+
+    /* An edge that is already there just gains the songs it is missing. */
+    size_t first, strength;
+    if (find_edge(id1, id2, first, strength)) {
+        add_songs(id1, id2, songList);
+        return;
+    }
+
+    first = songPool.size();
+    for (size_t i = 0; i < songList.size(); i++) {
+        uint32_t song = songList[i];
+        if (find(songPool.begin() + first, songPool.end(), song) ==
+            songPool.end()) {
+            songPool.push_back(song);
+        }
+    }
+    strength = songPool.size() - first;
+
+    own(id1)->neighbors.push_back(Edge(id2, first, strength));
+    own(id2)->neighbors.push_back(Edge(id1, first, strength));
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * renumber
+ * purpose: give every vertex a new ID, and lay the vertices and their
+ *          neighbor lists out in memory in the new ID order
+ *
+ * preconditions: 'order' holds every vertex ID exactly once
+ * postconditions: the vertex whose ID was order[i] now has ID i. Every
+ *                 vertex keeps its neighbors (and their songs) in the same
+ *                 order, so traversals visit the same artists in the same
+ *                 order as before.
+ *
+ * parameters: the current vertex IDs in their new order
+ * returns:    none
+ *
+ * notes: 1) throws a runtime_error if 'order' is not a permutation of the
+ *           vertex IDs, or if the graph is compressed (renumber first)
+ *        2) the vertices are copied to fresh arena memory in the new order;
+ *           the old copies stay in the arena until the graph is freed
+ *        3) a fork first copies everything it still shares with its base,
+ *           whose IDs it no longer has afterwards
+ */
+void CollabGraph::renumber(const vector<size_t> &order)
+{
+    enforce_uncompressed();
+    size_t count = vertices.size();
+    vector<size_t> newId(count, NO_VERTEX);
+    for (size_t i = 0; i < order.size(); i++) {
+        if (order[i] >= count or newId[order[i]] != NO_VERTEX) {
+            string message = "a vertex order must list every vertex once";
+            throw runtime_error(message.c_str());
+        }
+        newId[order[i]] = i;
+    }
+    if (order.size() != count) {
+        string message = "a vertex order must list every vertex once";
+        throw runtime_error(message.c_str());
+    }
+
+    detach();
+    vector<Vertex *> moved(count);
+    for (size_t i = 0; i < count; i++) {
+        const Vertex *old = vertices[order[i]];
+        Vertex *vertex = arena->make<Vertex>(old->name, arena.get());
+        vertex->id = i;
+        vertex->neighbors.reserve(old->neighbors.size());
+        for (size_t k = 0; k < old->neighbors.size(); k++) {
+            Edge edge = old->neighbors[k];
+            edge.neighbor = newId[edge.neighbor];
+            vertex->neighbors.push_back(edge);
+        }
+        moved[i] = vertex;
+    }
+    for (auto itr = graph->begin(); itr != graph->end(); itr++) {
+        itr->second = moved[newId[itr->second->id]];
+    }
+    vertices.swap(moved);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * compress
+ * purpose: re-encode every adjacency list into one byte array and free the
+ *          plain lists, shrinking the graph's edges to about a quarter
+ *
+ * postconditions: the neighbors of every vertex come back from neighbors()
+ *                 in the same order, with the same strengths and songs
+ *
+ * parameters: none
+ * returns:    none
+ *
+ * notes: 1) each vertex's edges are written as its degree and then, per
+ *           edge, three varints (7 bits a byte): the neighbor ID minus the
+ *           previous neighbor ID (the vertex's own ID for the first edge),
+ *           the strength, and the start of the song run minus where the
+ *           previous run ended. The differences are zigzag coded so small
+ *           negative ones stay short too.
+ *        2) the lists are not sorted first, which would make the neighbor
+ *           deltas smaller, because the order of the neighbors decides
+ *           which of several shortest paths a search finds. Renumbering
+ *           with an order that keeps neighbors close (see VertexOrder)
+ *           shrinks them instead, and has to be done before compressing.
+ *        3) the plain lists live in the arena, which cannot free pieces of
+ *           itself, so the arena is emptied and the names, songs and
+ *           vertices are copied back into it
+ *        4) compressing twice does nothing; a compressed graph cannot gain
+ *           edges or be renumbered
+ */
+void CollabGraph::compress()
+{
+    if (compressed) return;
+
+    size_t count = vertices.size();
+    packedStart.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const pmr::vector<Edge> &adj = vertices[i]->neighbors;
+        packedStart[i] = packed.size();
+        write_varint(packed, adj.size());
+
+        int64_t last = i, lastEnd = 0;
+        for (size_t k = 0; k < adj.size(); k++) {
+            int64_t step = (int64_t) adj[k].neighbor - last;
+            int64_t jump = (int64_t) adj[k].first - lastEnd;
+            write_varint(packed, ((uint64_t) step << 1) ^ (step >> 63));
+            write_varint(packed, adj[k].strength);
+            write_varint(packed, ((uint64_t) jump << 1) ^ (jump >> 63));
+            last = adj[k].neighbor;
+            lastEnd = adj[k].first + adj[k].strength;
+        }
+    }
+    packed.shrink_to_fit();
+
+    /* Start the arena over with just the names. */
+    vector<string> names(count), titles(songs.size());
+    for (size_t i = 0; i < count; i++) names[i] = vertices[i]->name;
+    for (size_t i = 0; i < songs.size(); i++) titles[i] = songs[i];
+    vector<uint32_t> pool;
+    vector<uint8_t> bytes;
+    vector<uint64_t> starts;
+    pool.swap(songPool);
+    bytes.swap(packed);
+    starts.swap(packedStart);
+    self_destruct();
+    songPool.swap(pool);
+    packed.swap(bytes);
+    packedStart.swap(starts);
+
+    graph->reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        Vertex *vertex = arena->make<Vertex>(arena->copy_string(names[i]),
+                                             arena.get());
+        vertex->id = i;
+        vertices.push_back(vertex);
+        graph->insert({stored_key(vertex->name), vertex});
+    }
+    songIds->reserve(titles.size());
+    for (size_t i = 0; i < titles.size(); i++) {
+        songs.push_back(arena->copy_string(titles[i]));
+        songIds->insert({stored_key(songs[i]), i});
+    }
+    compressed = true;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * open_file
+ * purpose: replace the graph with a graph file written by save(), mapped
+ *          read-only instead of loaded
+ *
+ * postconditions: the graph has the saved vertices, edges and songs, with
+ *                 the same IDs, and cannot be changed
+ *
+ * parameters: the name of the graph file
+ * returns:    none
+ *
+ * notes: throws a runtime_error if the file cannot be mapped or is not a
+ *        graph file (see GraphFile::open); the graph is then left empty
+ */
+void CollabGraph::open_file(const string &path)
+{
+    self_destruct();
+    file.open(path);
+    compressed = true; //the lists are read just like compress() left them
+    metadata.resize(vertex_count());
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * intern_song
+ * purpose: give a song title its song ID, storing the title only once
+ *
+ * parameters: a song title, which must be non-empty
+ * returns:    the song ID of that title (the same ID every time)
+ */
+size_t CollabGraph::intern_song(string_view song)
+{
+    enforce_unmapped();
+    if (song.empty()) {
+        string message = "the empty string is not a valid edge name";
+        throw runtime_error(message.c_str());
+    }
+
+    string scratch;
+    auto found = songIds->find(key_of(song, scratch));
+    if (found != songIds->end()) return found->second;
+    if (base != nullptr) { //a fork's own map only has the titles it added
+        size_t shared = base->find_song(string(song));
+        if (shared != NO_SONG) return shared;
+    }
+
+    if (songs.size() >= UINT32_MAX) { //song IDs are 32 bits in the pool
+        string message = "too many songs for the song pool";
+        throw runtime_error(message.c_str());
+    }
+    string_view title = arena->copy_string(song);
+    songIds->insert({stored_key(title), songs.size()});
+    songs.push_back(title);
+    return songs.size() - 1;
+}
+
 
-    graph.at(a1.get_name())->neighbors.push_back(Edge(a2, edgeName));
-    graph.at(a2.get_name())->neighbors.push_back(Edge(a1, edgeName));
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * normalize_names
+ * purpose: choose whether names are interned as they are spelled or by
+ *          their normal form (see NameFold)
+ *
+ * parameters: true to intern by normal form
+ * returns:    none
+ *
+ * notes: 1) names looked up afterwards are folded the same way, so any
+ *           spelling of a name finds it
+ *        2) throws a runtime_error unless the graph is still empty, since
+ *           names already interned may fold together
+ */
+void CollabGraph::normalize_names(bool on)
+{
+    enforce_unmapped();
+    if (not vertices.empty() or not songs.empty()) {
+        string message = "names can only be normalized in an empty graph";
+        throw runtime_error(message.c_str());
+    }
+    normalized = on;
 }
 
 
@@ -224,8 +607,7 @@ void CollabGraph::insert_edge(const Artist &a1, const Artist &a2,
  */
 void CollabGraph::mark_vertex(const Artist &artist)
 {
-    enforce_valid_vertex(artist);
-    graph.at(artist.get_name())->visited = true;
+    metadata.mark(get_vertex_id(artist));
 }
 
 
@@ -240,8 +622,7 @@ void CollabGraph::mark_vertex(const Artist &artist)
  */
 void CollabGraph::unmark_vertex(const Artist &artist)
 {
-    enforce_valid_vertex(artist);
-    graph.at(artist.get_name())->visited = false;
+    metadata.unmark(get_vertex_id(artist));
 }
 
 
@@ -263,18 +644,10 @@ void CollabGraph::unmark_vertex(const Artist &artist)
  */
 void CollabGraph::set_predecessor(const Artist &to, const Artist &from)
 {
-    enforce_valid_vertex(to);
-    enforce_valid_vertex(from);
-
-    Vertex *vertex      = graph.at(to.get_name());
-    Vertex *pred_vertex = graph.at(from.get_name());
-
     /* It is a mistake to set the predecessor of a vertex if it
-     * already has one.
+     * already has one, so the SearchState keeps the first one it is given.
      */
-    if (vertex->predecessor == nullptr) {
-        vertex->predecessor = pred_vertex;
-    }
+    metadata.set_predecessor(get_vertex_id(to), get_vertex_id(from));
 }
 
 
@@ -294,14 +667,9 @@ void CollabGraph::set_predecessor(const Artist &to, const Artist &from)
  */
 void CollabGraph::clear_metadata()
 {
-    /* Again, we use the std::iterator to iterate over an unordered_map. 
-     * Whereas the graph.at() function returns just the "value", when we
-     * iterate we're getting the (key, value) pairs, so we have to 
-     * traverse to the second element in the pair to get the vertex itself. */
-    for (auto itr = graph.begin(); itr != graph.end(); itr++) {
-        itr->second->visited = false;
-        itr->second->predecessor = nullptr;
-    }
+    /* Starting a new search in the SearchState forgets every mark and
+     * predecessor at once, without walking the vertices. */
+    metadata.reset(vertex_count());
 }
 
 
@@ -316,7 +684,7 @@ void CollabGraph::clear_metadata()
  */
 bool CollabGraph::is_vertex(const Artist &artist) const
 {
-    return graph.find(artist.get_name()) != graph.end();
+    return find_vertex(artist.get_name()) != NO_VERTEX;
 }
 
 
@@ -330,8 +698,7 @@ bool CollabGraph::is_vertex(const Artist &artist) const
  */
 bool CollabGraph::is_marked(const Artist &artist) const
 {
-    enforce_valid_vertex(artist);
-    return graph.at(artist.get_name())->visited;
+    return metadata.is_marked(get_vertex_id(artist));
 }
 
 
@@ -347,17 +714,14 @@ bool CollabGraph::is_marked(const Artist &artist) const
  */
 Artist CollabGraph::get_predecessor(const Artist &artist) const
 {
-    enforce_valid_vertex(artist);
-
     /* An artist with the empty string as its name represents a
      * non-existent artist */
     Artist pred_artist;
     
-    
-    Vertex *pred_vertex = graph.at(artist.get_name())->predecessor;
+    size_t pred_id = metadata.get_predecessor(get_vertex_id(artist));
 
-    if (pred_vertex != nullptr)
-        pred_artist = pred_vertex->artist;
+    if (pred_id != NO_VERTEX)
+        pred_artist = get_vertex(pred_id);
 
     return pred_artist;
 }
@@ -375,30 +739,29 @@ Artist CollabGraph::get_predecessor(const Artist &artist) const
  */
 string CollabGraph::get_edge(const Artist &a1, const Artist &a2) const
 {
-    enforce_valid_vertex(a1);
-    enforce_valid_vertex(a2);
+    return get_edge(get_vertex_id(a1), get_vertex_id(a2));
+}
 
-    /* The 'neighbors' and 'edgeNames' vectors are parallel arrays.
-     *
-     * The 'index' is increased until the end of the adjacency list
-     * is reached OR a2 is found in the adjacency list.
-     */
-    vector<Edge> adj = graph.at(a1.get_name())->neighbors;
 
-    size_t idx = 0;
-    bool found = false;
-    while (not found and idx < adj.size()) {
-        if (adj[idx].neighbor == a2) {
-            found = true;
-        }
-        else idx++;
-    }
 
-    /* If a1 and a2 are neighbors, extract the name of the edge that
-     * connects them. Otherwise, 'edge' stays ""
-     */
-    if (idx < adj.size()) return adj[idx].song;
-    else                  return "";
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_songs
+ * purpose: retrieve every song on the edge between two vertices
+ *
+ * parameters: 1) a const Artist reference, which should be in the graph
+ *             2) a const Artist reference, which should be in the graph
+ * returns:    the titles of all songs the two artists share, first song
+ *             first; empty if there is no edge connecting them
+ */
+vector<string> CollabGraph::get_songs(const Artist &a1,
+                                      const Artist &a2) const
+{
+    vector<size_t> ids = get_song_ids(get_vertex_id(a1), get_vertex_id(a2));
+    vector<string> titles;
+    for (size_t i = 0; i < ids.size(); i++) {
+        titles.push_back(string(title_of(ids[i])));
+    }
+    return titles;
 }
 
 
@@ -413,16 +776,15 @@ string CollabGraph::get_edge(const Artist &a1, const Artist &a2) const
  */
 vector<Artist> CollabGraph::get_vertex_neighbors(const Artist &artist) const
 {
-    enforce_valid_vertex(artist); //not sure if needed...
     vector<Artist> result;
     
-    Vertex *currArtist = graph.at(artist.get_name());
+    Neighbors edge = neighbors(get_vertex_id(artist));
     
-    //get all neighbors for an artist, use neighbor.size()
-    for (size_t i = 0; i < currArtist->neighbors.size(); i++) {
+    //get all neighbors for an artist, one edge at a time
+    while (edge.next()) {
         
         //each neighbor is an edge, get the artist from each edge.
-        result.push_back(currArtist->neighbors.at(i).neighbor);
+        result.push_back(get_vertex(edge.neighbor()));
     }
     
     return result;
@@ -449,29 +811,16 @@ vector<Artist> CollabGraph::get_vertex_neighbors(const Artist &artist) const
 stack<Artist> CollabGraph::report_path(const Artist &source,
                                             const Artist &dest) const
 {
-    enforce_valid_vertex(source); //check for valid source
-    enforce_valid_vertex(dest); //check for valid destination
+    //check for valid source and destination; an empty result means no path
+    vector<size_t> ids = metadata.path(get_vertex_id(source),
+                                       get_vertex_id(dest));
     
     stack<Artist> path;
     
-    if (source == dest) return path; //check for duplicates
-    
-    string name = dest.get_name();
-    Vertex *pathing = graph.at(name); //need to work with vertices
-    
-    //CHECK IF NO PATH IS AVAILABLE
-    
-    if (pathing->predecessor == nullptr) return path;
-    
-    
-    
-    //check 2 conditions: Either at the beginning of path or no path.
-    while ((pathing->artist != source) and (pathing != nullptr)) {
-        path.push(pathing->artist);
-        pathing = pathing->predecessor;
+    //push from the destination back so the source ends up on top
+    for (size_t i = ids.size(); i > 0; i--) {
+        path.push(get_vertex(ids[i - 1]));
     }
-    
-    path.push(source); //push source
 
     return path;
 }
@@ -488,68 +837,966 @@ stack<Artist> CollabGraph::report_path(const Artist &source,
  */
 void CollabGraph::print_graph(ostream &out)
 {
-    for (auto itr = graph.begin(); itr != graph.end(); itr++) {
+    for (size_t id = 0; id < vertex_count(); id++) {
 
-        vector<Edge> neighbors = itr->second->neighbors;
+        Neighbors edge = neighbors(id);
 
-        for (size_t i = 0; i < neighbors.size(); i++) {
-            out << "\"" << itr->second->artist.get_name() << "\" "
+        while (edge.next()) {
+            out << "\"" << name_of(id) << "\" "
                 << "collaborated with "
-                << "\"" << neighbors.at(i).neighbor << "\" in "
-                << "\"" << neighbors.at(i).song << "\"."
-                << endl;
+                << "\"" << name_of(edge.neighbor())
+                << "\" in "
+                << "\"" << title_of(edge.first_song()) << "\".\n";
         }
 
-        out << "***" << endl;
+        out << "***\n";
     }
 
 }
 
 
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * save
+ * purpose: write the graph to a file that open_file can map
+ *
+ * preconditions: the graph is compressed (and was renumbered first, if it
+ *                is going to be)
+ * parameters: the name of the file to write
+ * returns:    none
+ *
+ * notes: throws a runtime_error if the graph is not compressed, is itself
+ *        mapped from a file, or if the file cannot be written
+ */
+void CollabGraph::save(const string &path) const
+{
+    if (not compressed or file.is_open()) {
+        string message = "only a compressed graph that is not already a "
+                         "graph file can be saved";
+        throw runtime_error(message.c_str());
+    }
 
-
-/**********************************************************************
- ******************** private function definitions ********************
- **********************************************************************/
+    GraphFile::Contents contents;
+    contents.names.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        contents.names.push_back(vertices[i]->name);
+    }
+    contents.titles = vector<string_view>(songs.begin(), songs.end());
+    contents.adjacency = packed.data();
+    contents.adjacencyBytes = packed.size();
+    contents.adjacencyStarts = packedStart.data();
+    contents.pool = songPool.data();
+    contents.poolCount = songPool.size();
+    GraphFile::write(path, contents);
+}
 
 
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * self_destruct
- * purpose: free all memory associated with this CollabGraph
- *          instance
+ * vertex_count
+ * purpose: report how many vertices are in the collaboration graph
  *
  * parameters: none
- * returns: none
+ * returns: the number of vertices, which is one past the largest vertex ID
  */
-void CollabGraph::self_destruct()
+size_t CollabGraph::vertex_count() const
+{
+    if (file.is_open()) return file.vertex_count();
+    return vertices.size();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_vertex_id
+ * purpose: retrieve the ID of a vertex in the collaboration graph
+ *
+ * parameters: a const Artist reference, which should be in the graph
+ * returns:    the vertex ID of the artist. IDs are dense, start at 0 and are
+ *             handed out in the order the vertices were inserted
+ */
+size_t CollabGraph::get_vertex_id(const Artist &artist) const
+{
+    enforce_valid_vertex(artist);
+    return find_vertex(artist.get_name());
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_vertex
+ * purpose: retrieve the artist stored at a vertex ID
+ *
+ * parameters: a vertex ID, which must be less than vertex_count()
+ * returns:    the Artist at that vertex
+ *
+ * notes: throws a runtime_error if the ID is out of range
+ */
+Artist CollabGraph::get_vertex(size_t id) const
+{
+    enforce_valid_id(id);
+    return Artist(string(name_of(id)));
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * find_vertex
+ * purpose: look up the vertex ID of an artist name without throwing
+ *
+ * parameters: an artist name
+ * returns:    the vertex ID, or NO_VERTEX if the name is not in the graph
+ */
+size_t CollabGraph::find_vertex(const string &name) const
 {
-    for (auto itr = graph.begin(); itr != graph.end(); itr++) {
-        delete itr->second;
+    if (file.is_open()) {
+        size_t id = file.find_name(name);
+        return id == GraphFile::NOT_FOUND ? NO_VERTEX : id;
     }
+    string scratch;
+    auto itr = graph->find(key_of(name, scratch));
+    if (itr != graph->end()) return itr->second->id;
+    if (base != nullptr) return base->find_vertex(name); //see detach
+    return NO_VERTEX;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_name
+ * purpose: retrieve the name of the artist stored at a vertex ID
+ *
+ * parameters: a vertex ID, which must be less than vertex_count()
+ * returns:    the artist's name
+ */
+string CollabGraph::get_name(size_t id) const
+{
+    enforce_valid_id(id);
+    return string(name_of(id));
+}
+
 
-    graph.clear();
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * name_view
+ * purpose: get_name without the copy, for output that touches many artists
+ *
+ * parameters: a vertex ID, which must be less than vertex_count()
+ * returns:    the artist's name, valid for as long as the graph is
+ */
+string_view CollabGraph::name_view(size_t id) const
+{
+    enforce_valid_id(id);
+    return name_of(id);
 }
 
 
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
- * enforce_valid_vertex
- * purpose: ensure that the given artist is in the graph; throw an error if it
- *          is not. if an exception is not thrown, then the provided Artist
- *          instance maps to a vertex in the collaboration graph
+ * degree
+ * purpose: count the neighbors of a vertex
  *
- * parameters: a const Artist reference, which should map to a vertex in
- *             the collaboration graph
- * returns: none
+ * parameters: a vertex ID, which must be less than vertex_count()
+ * returns:    the number of edges at that vertex
  */
-void CollabGraph::enforce_valid_vertex(const Artist &artist) const
+size_t CollabGraph::degree(size_t id) const
 {
-    if (not is_vertex(artist)) {
-        string message = "artist \"" + artist.get_name() + \
-                              "\" does not exist in the collaboration graph";
-        throw runtime_error(message.c_str());
+    if (compressed) { //the degree is the first thing encoded
+        const uint8_t *at = file.is_open() ? file.adjacency(id)
+                                           : &packed[packedStart[id]];
+        return read_varint(at);
     }
+    return vertices[id]->neighbors.size();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_neighbor
+ * purpose: retrieve one neighbor of a vertex, in the same order that
+ *          get_vertex_neighbors would list them
+ *
+ * parameters: 1) a vertex ID, which must be less than vertex_count()
+ *             2) an index, which must be less than degree(id)
+ * returns:    the vertex ID of the i-th neighbor
+ *
+ * notes: like operator[] on a vector, this trusts its arguments instead
+ *        of checking them. On a compressed graph it decodes the first i
+ *        edges to get there, so traversals use neighbors() instead.
+ */
+size_t CollabGraph::get_neighbor(size_t id, size_t i) const
+{
+    if (not compressed) return vertices[id]->neighbors[i].neighbor;
+
+    Neighbors edge = neighbors(id);
+    for (size_t k = 0; k <= i; k++) edge.next();
+    return edge.neighbor();
 }
 
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_neighbor_strength
+ * purpose: retrieve the strength of the edge to one neighbor of a vertex
+ *
+ * parameters: 1) a vertex ID, which must be less than vertex_count()
+ *             2) an index, which must be less than degree(id)
+ * returns:    how many songs the vertex shares with its i-th neighbor
+ *
+ * notes: like get_neighbor, this does not check its arguments
+ */
+size_t CollabGraph::get_neighbor_strength(size_t id, size_t i) const
+{
+    if (not compressed) return vertices[id]->neighbors[i].strength;
+
+    Neighbors edge = neighbors(id);
+    for (size_t k = 0; k <= i; k++) edge.next();
+    return edge.strength();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * is_compressed
+ * purpose: report whether compress() has been called
+ *
+ * parameters: none
+ * returns: true if the adjacency lists are stored compressed
+ */
+bool CollabGraph::is_compressed() const
+{
+    return compressed;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * is_mapped
+ * purpose: report whether the graph is a graph file opened by open_file
+ *
+ * parameters: none
+ * returns: true if the graph is read from a memory-mapped file
+ */
+bool CollabGraph::is_mapped() const
+{
+    return file.is_open();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * is_normalized
+ * purpose: report whether names are interned by their normal form
+ *
+ * parameters: none
+ * returns: true if normalize_names turned it on
+ */
+bool CollabGraph::is_normalized() const
+{
+    return normalized;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * is_fork
+ * purpose: report whether the graph still shares memory with a base graph
+ *
+ * parameters: none
+ * returns: true if the graph was forked and has not copied everything yet
+ */
+bool CollabGraph::is_fork() const
+{
+    return base != nullptr;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * memory
+ * purpose: report how many bytes each part of the graph holds
+ *
+ * parameters: none
+ * returns:    the bytes per part (see Memory)
+ *
+ * notes: 1) walks the vertices and the name maps once; no adjacency list
+ *           is copied or decoded
+ *        2) a map entry is taken to cost the entry and one pointer, and a
+ *           bucket one pointer, as in libstdc++'s unordered_map
+ *        3) slack is what the arena reserved beyond the names, entries,
+ *           vertices and plain lists in it: the unused end of its newest
+ *           block, and the buffers adjacency lists left behind as they grew
+ *        4) a mapped graph's file is counted whole, though only the pages
+ *           searches have read take memory
+ *        5) a fork counts only what it does not share with its base
+ */
+CollabGraph::Memory CollabGraph::memory() const
+{
+    Memory used = Memory();
+    size_t lists = 0; //plain adjacency lists, which are in the arena
+    size_t records = 0;
+    for (size_t i = 0; i < vertices.size(); i++) {
+        if (i < borrowed.size() and borrowed[i]) continue; //the base's
+        if (i >= borrowed.size()) used.names += vertices[i]->name.size();
+        lists += vertices[i]->neighbors.capacity() * sizeof(Edge);
+        records += sizeof(Vertex);
+    }
+    for (size_t i = borrowedSongs; i < songs.size(); i++) {
+        used.names += songs[i].size();
+    }
+    for (auto itr = graph->begin(); itr != graph->end(); itr++) {
+        if (itr->first.data() != itr->second->name.data()) {
+            used.names += itr->first.size(); //a key of its own
+        }
+    }
+    for (auto itr = songIds->begin(); itr != songIds->end(); itr++) {
+        if (itr->first.data() != songs[itr->second].data()) {
+            used.names += itr->first.size();
+        }
+    }
+    used.maps = graph->size() * (sizeof(*graph->begin()) + sizeof(void *)) +
+                graph->bucket_count() * sizeof(void *) +
+                songIds->size() * (sizeof(*songIds->begin()) +
+                                   sizeof(void *)) +
+                songIds->bucket_count() * sizeof(void *);
+
+    used.vertices = records + vertices.capacity() * sizeof(Vertex *) +
+                    songs.capacity() * sizeof(string_view);
+    used.adjacency = lists + packed.capacity() +
+                     packedStart.capacity() * sizeof(uint64_t);
+    used.pool = songPool.capacity() * sizeof(uint32_t);
+
+    size_t inArena = used.names + used.maps + records + lists;
+    if (arena->bytes_reserved() > inArena) {
+        used.slack = arena->bytes_reserved() - inArena;
+    }
+    used.mapped = file.is_open() ? file.bytes() : 0;
+    used.metadata = metadata.bytes();
+    return used;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * neighbors
+ * purpose: start walking the edges of a vertex
+ *
+ * parameters: a vertex ID, which must be less than vertex_count()
+ * returns:    an iterator whose next() steps to each edge in turn, in the
+ *             same order that get_vertex_neighbors lists them
+ *
+ * notes: like get_neighbor, this does not check its argument
+ */
+CollabGraph::Neighbors CollabGraph::neighbors(size_t id) const
+{
+    Neighbors edges;
+    edges.pool       = song_runs();
+    edges.compressed = compressed;
+    edges.plain      = nullptr;
+    edges.plainEnd   = nullptr;
+    edges.at         = nullptr;
+    edges.left       = 0;
+    edges.lastCount  = 0;
+    edges.id         = id; //the first neighbor is coded relative to this
+    edges.first      = 0;
+    edges.count      = 0;
+
+    if (compressed) {
+        edges.at   = file.is_open() ? file.adjacency(id)
+                                    : &packed[packedStart[id]];
+        edges.left = read_varint(edges.at);
+    } else {
+        const pmr::vector<Edge> &adj = vertices[id]->neighbors;
+        edges.plain    = adj.data();
+        edges.plainEnd = adj.data() + adj.size();
+    }
+    return edges;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_edge (by vertex ID)
+ * purpose: retrieve the edge between two vertices in the collaboration graph
+ *
+ * parameters: two vertex IDs, which must be less than vertex_count()
+ * returns:    a string, which is the name of the edge connecting them, or
+ *             the empty string if there is no edge connecting them
+ */
+string CollabGraph::get_edge(size_t id1, size_t id2) const
+{
+    enforce_valid_id(id1);
+    enforce_valid_id(id2);
+
+    /* The first song in the edge's run names the edge. */
+    size_t first, strength;
+    if (not find_edge(id1, id2, first, strength)) return "";
+    return string(title_of(song_runs()[first]));
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_strength
+ * purpose: retrieve the strength of the edge between two vertices
+ *
+ * parameters: two vertex IDs, which must be less than vertex_count()
+ * returns:    how many songs the two artists share, or 0 if there is no
+ *             edge connecting them
+ */
+size_t CollabGraph::get_strength(size_t id1, size_t id2) const
+{
+    enforce_valid_id(id1);
+    enforce_valid_id(id2);
+
+    size_t first, strength;
+    if (not find_edge(id1, id2, first, strength)) return 0;
+    return strength;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_song_ids
+ * purpose: retrieve the song IDs on the edge between two vertices
+ *
+ * parameters: two vertex IDs, which must be less than vertex_count()
+ * returns:    the song IDs of all songs the two artists share, first song
+ *             first; empty if there is no edge connecting them
+ */
+vector<size_t> CollabGraph::get_song_ids(size_t id1, size_t id2) const
+{
+    enforce_valid_id(id1);
+    enforce_valid_id(id2);
+
+    vector<size_t> result;
+    size_t first, strength;
+    if (not find_edge(id1, id2, first, strength)) return result;
+
+    for (size_t i = 0; i < strength; i++) {
+        result.push_back(song_runs()[first + i]);
+    }
+    return result;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * song_count
+ * purpose: report how many distinct songs are on the graph's edges
+ *
+ * parameters: none
+ * returns: the number of song IDs handed out
+ */
+size_t CollabGraph::song_count() const
+{
+    if (file.is_open()) return file.song_count();
+    return songs.size();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_song
+ * purpose: retrieve the title of a song ID
+ *
+ * parameters: a song ID, which must be less than song_count()
+ * returns:    the song's title
+ */
+string CollabGraph::get_song(size_t songId) const
+{
+    if (songId >= song_count()) {
+        string message = "song ID " + to_string(songId) + \
+                              " does not exist in the collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+    return string(title_of(songId));
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * song_view
+ * purpose: get_song without the copy
+ *
+ * parameters: a song ID, which must be less than song_count()
+ * returns:    the song's title, valid for as long as the graph is
+ */
+string_view CollabGraph::song_view(size_t songId) const
+{
+    if (songId >= song_count()) {
+        string message = "song ID " + to_string(songId) + \
+                              " does not exist in the collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+    return title_of(songId);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * find_song
+ * purpose: look up the song ID of a title
+ *
+ * parameters: a song title
+ * returns:    the song ID, or NO_SONG if no edge has that song
+ */
+size_t CollabGraph::find_song(const string &title) const
+{
+    if (file.is_open()) {
+        size_t id = file.find_title(title);
+        return id == GraphFile::NOT_FOUND ? NO_SONG : id;
+    }
+    string scratch;
+    auto it = songIds->find(key_of(title, scratch));
+    if (it != songIds->end()) return it->second;
+    if (base != nullptr) return base->find_song(title);
+    return NO_SONG;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Neighbors::open_song
+ * purpose: find a song on the current edge that is not blocked, which is
+ *          what decides whether a song-filtered search may use that edge
+ *
+ * preconditions: next() has returned true
+ * parameters: the song IDs that may not be used
+ * returns:    the first song ID in the edge's run that is not in 'blocked',
+ *             or NO_SONG if every song on the edge is blocked
+ *
+ * notes: the run is contiguous in the pool and most edges hold a single
+ *        song, so this is usually one bit test
+ */
+size_t CollabGraph::Neighbors::open_song(const VertexSet &blocked) const
+{
+    for (size_t k = 0; k < count; k++) {
+        size_t song = pool[first + k];
+        if (not blocked.contains(song)) return song;
+    }
+    return NO_SONG;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Neighbors::open_songs
+ * purpose: count the songs on the current edge that are not blocked: the
+ *          edge's strength for a search that may not use the others
+ *
+ * preconditions: next() has returned true
+ * parameters: the song IDs that may not be used
+ * returns:    how many songs in the edge's run are not in 'blocked'
+ */
+size_t CollabGraph::Neighbors::open_songs(const VertexSet &blocked) const
+{
+    size_t open = 0;
+    for (size_t k = 0; k < count; k++) {
+        if (not blocked.contains(pool[first + k])) open++;
+    }
+    return open;
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * self_destruct
+ * purpose: free all memory associated with this CollabGraph
+ *          instance
+ *
+ * parameters: none
+ * returns: none
+ *
+ * notes: the vertices and the maps are never deleted one by one; every
+ *        block of the arena is given back at once and new, empty maps are
+ *        made. A fork lets go of its base, which is freed too if nothing
+ *        else holds it.
+ */
+void CollabGraph::self_destruct()
+{
+    vertices.clear();
+    songs.clear();
+    songPool.clear();
+    packed.clear();
+    packedStart.clear();
+    compressed = false;
+    file.close();
+    borrowed.clear();
+    borrowedSongs = 0;
+    base.reset();
+    arena->release();
+    make_maps();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * make_maps
+ * purpose: make empty name maps in the arena
+ *
+ * parameters: none
+ * returns: none
+ *
+ * notes: the maps are made in the arena they allocate from and, like the
+ *        vertices, are never destroyed: releasing the arena frees them
+ *        without visiting their entries
+ */
+void CollabGraph::make_maps()
+{
+    graph = arena->make<VertexMap>(arena.get());
+    songIds = arena->make<SongMap>(arena.get());
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * copy_from
+ * purpose: fill an empty graph with a copy of another, keeping its vertex
+ *          and song IDs
+ *
+ * parameters: the graph to copy, which may be a fork
+ * returns: none
+ *
+ * notes: 1) the copy walks the vertices in ID order, so each record and
+ *           its adjacency list land next to each other in the arena, and
+ *           each list is copied whole; the song pool and the compressed
+ *           lists are copied as whole arrays, and run starts are kept
+ *        2) the name maps are sized for every name up front and rebuilt
+ *           from the copied names, so nothing points into 'source'
+ *        3) a mapped graph is copied by sharing its mapping (see
+ *           GraphFile::share), so the copy reads the same pages of the same
+ *           file, whatever has happened to the path since
+ */
+void CollabGraph::copy_from(const CollabGraph &source)
+{
+    normalized = source.normalized;
+    if (source.file.is_open()) { //the same settings as open_file
+        file.share(source.file);
+        compressed = true;
+        metadata.resize(vertex_count());
+        return;
+    }
+
+    size_t count = source.vertices.size();
+    vertices.reserve(count);
+    graph->reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const Vertex *from = source.vertices[i];
+        Vertex *vertex = arena->make<Vertex>(arena->copy_string(from->name),
+                                             arena.get());
+        vertex->id = i;
+        vertex->neighbors.assign(from->neighbors.begin(),
+                                 from->neighbors.end());
+        vertices.push_back(vertex);
+        graph->insert({stored_key(vertex->name), vertex});
+    }
+
+    songs.reserve(source.songs.size());
+    songIds->reserve(source.songs.size());
+    for (size_t i = 0; i < source.songs.size(); i++) {
+        songs.push_back(arena->copy_string(source.songs[i]));
+        songIds->insert({stored_key(songs[i]), i});
+    }
+
+    songPool = source.songPool;
+    compressed = source.compressed;
+    packed = source.packed;
+    packedStart = source.packedStart;
+    metadata.resize(count);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * own
+ * purpose: make a vertex's record and adjacency list the graph's own, so
+ *          they can be changed
+ *
+ * parameters: a valid vertex ID
+ * returns: the vertex, in the graph's own arena
+ *
+ * notes: only a fork has vertices that are not its own; the first change
+ *        to one copies its record and list (with room to grow), and the
+ *        name stays shared with the base until detach
+ */
+CollabGraph::Vertex *CollabGraph::own(size_t id)
+{
+    if (id < borrowed.size() and borrowed[id]) {
+        const Vertex *shared = vertices[id];
+        Vertex *vertex = arena->make<Vertex>(shared->name, arena.get());
+        vertex->id = id;
+        vertex->neighbors.reserve(shared->neighbors.size() + 1);
+        vertex->neighbors.assign(shared->neighbors.begin(),
+                                 shared->neighbors.end());
+        vertices[id] = vertex;
+        borrowed[id] = false;
+    }
+    return vertices[id];
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * detach
+ * purpose: copy whatever a fork still shares with its base, and let the
+ *          base go
+ *
+ * parameters: none
+ * returns: none
+ *
+ * notes: afterwards the name maps hold every name, so lookups no longer
+ *        fall back to the base; does nothing if the graph is not a fork
+ */
+void CollabGraph::detach()
+{
+    if (base == nullptr) return;
+
+    graph->reserve(vertices.size());
+    for (size_t i = 0; i < borrowed.size(); i++) {
+        Vertex *vertex = own(i);
+        vertex->name = arena->copy_string(vertex->name);
+        graph->insert({stored_key(vertex->name), vertex});
+    }
+    songIds->reserve(songs.size());
+    for (size_t i = 0; i < borrowedSongs; i++) {
+        songs[i] = arena->copy_string(songs[i]);
+        songIds->insert({stored_key(songs[i]), i});
+    }
+    borrowed.clear();
+    borrowedSongs = 0;
+    base.reset();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * enforce_valid_vertex
+ * purpose: ensure that the given artist is in the graph; throw an error if it
+ *          is not. if an exception is not thrown, then the provided Artist
+ *          instance maps to a vertex in the collaboration graph
+ *
+ * parameters: a const Artist reference, which should map to a vertex in
+ *             the collaboration graph
+ * returns: none
+ */
+void CollabGraph::enforce_valid_vertex(const Artist &artist) const
+{
+    if (not is_vertex(artist)) {
+        string message = "artist \"" + artist.get_name() + \
+                              "\" does not exist in the collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * enforce_valid_id
+ * purpose: ensure that the given vertex ID is in the graph; throw an error if
+ *          it is not
+ *
+ * parameters: a vertex ID
+ * returns: none
+ */
+void CollabGraph::enforce_valid_id(size_t id) const
+{
+    if (id >= vertex_count()) {
+        string message = "vertex ID " + to_string(id) + \
+                              " does not exist in the collaboration graph";
+        throw runtime_error(message.c_str());
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * enforce_unmapped
+ * purpose: ensure that the graph can still be changed at all; throw an
+ *          error if it is mapped from a graph file
+ *
+ * parameters: none
+ * returns: none
+ */
+void CollabGraph::enforce_unmapped() const
+{
+    if (file.is_open()) {
+        string message = "a collaboration graph mapped from a file cannot "
+                         "be changed";
+        throw runtime_error(message.c_str());
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * enforce_uncompressed
+ * purpose: ensure that the adjacency lists can still be changed; throw an
+ *          error if the graph has been compressed
+ *
+ * parameters: none
+ * returns: none
+ */
+void CollabGraph::enforce_uncompressed() const
+{
+    enforce_unmapped();
+    if (compressed) {
+        string message = "a compressed collaboration graph cannot be "
+                         "changed";
+        throw runtime_error(message.c_str());
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * find_edge
+ * purpose: find the edge from one vertex to another
+ *
+ * parameters: two valid vertex IDs, and where to put the edge's song run
+ * returns: true, with the start and length of the edge's run in 'songPool'
+ *          stored in 'first' and 'strength', if id1 has an edge to id2
+ */
+bool CollabGraph::find_edge(size_t id1, size_t id2, size_t &first,
+                            size_t &strength) const
+{
+    /* Walk the adjacency list until id2 shows up or the list runs out. */
+    Neighbors edge = neighbors(id1);
+    while (edge.next()) {
+        if (edge.neighbor() == id2) {
+            first = edge.first;
+            strength = edge.count;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * add_songs
+ * purpose: add songs to an edge that already exists
+ *
+ * parameters: two vertex IDs with an edge between them, and song IDs
+ * returns: none
+ *
+ * notes: a run can only grow in place when it is the last run in the pool,
+ *        so otherwise it is first moved to the end of the pool. The old copy
+ *        is left behind; loading inserts each edge once, so this only costs
+ *        space when edges are extended one song at a time.
+ */
+void CollabGraph::add_songs(size_t id1, size_t id2, const vector<size_t> &add)
+{
+    Edge *there = nullptr;
+    Edge *back  = nullptr;
+    pmr::vector<Edge> &adj1 = own(id1)->neighbors;
+    pmr::vector<Edge> &adj2 = own(id2)->neighbors;
+    for (size_t i = 0; i < adj1.size(); i++) {
+        if (adj1[i].neighbor == id2) there = &adj1[i];
+    }
+    for (size_t i = 0; i < adj2.size(); i++) {
+        if (adj2[i].neighbor == id1) back = &adj2[i];
+    }
+
+    for (size_t i = 0; i < add.size(); i++) {
+        uint32_t song = add[i];
+        auto start = songPool.begin() + there->first;
+        if (find(start, start + there->strength, song) !=
+            start + there->strength) {
+            continue; //already on this edge
+        }
+
+        if (there->first + there->strength != songPool.size()) {
+            size_t moved = songPool.size();
+            for (size_t k = 0; k < there->strength; k++) {
+                songPool.push_back(songPool[there->first + k]);
+            }
+            there->first = moved;
+        }
+        songPool.push_back(song);
+        there->strength++;
+    }
+    *back = Edge(id1, there->first, there->strength);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * write_varint
+ * purpose: append a number to a byte array, seven bits a byte, low bits
+ *          first, with the top bit set on every byte but the last
+ *
+ * parameters: the byte array and the number
+ * returns: none
+ */
+void CollabGraph::write_varint(vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t) value);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * name_of / title_of / song_runs
+ * purpose: read an artist name, a song title or the song ID pool from
+ *          wherever the graph keeps them: its own memory, or the mapped
+ *          graph file
+ *
+ * parameters: a valid vertex ID or song ID
+ */
+string_view CollabGraph::name_of(size_t id) const
+{
+    if (file.is_open()) return file.name(id);
+    return vertices[id]->name;
+}
+
+string_view CollabGraph::title_of(size_t songId) const
+{
+    if (file.is_open()) return file.title(songId);
+    return songs[songId];
+}
+
+const uint32_t *CollabGraph::song_runs() const
+{
+    if (file.is_open()) return file.pool();
+    return songPool.data();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * key_of / stored_key
+ * purpose: the key a name is interned under: the name itself, or its
+ *          NameFold form when names are normalized
+ *
+ * parameters: key_of: the name and a string to fold it into
+ *             stored_key: a name already copied into the arena
+ * returns:    the key; stored_key's is in the arena too, and is the name
+ *             itself (no second copy) when the name is already normal
+ */
+string_view CollabGraph::key_of(string_view name, string &scratch) const
+{
+    if (not normalized) return name;
+    return NameFold::fold(name, scratch);
+}
+
+string_view CollabGraph::stored_key(string_view stored)
+{
+    string scratch;
+    string_view key = key_of(stored, scratch);
+    if (key.data() == stored.data()) return stored;
+    return arena->copy_string(key);
+}
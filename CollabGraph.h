@@ -14,6 +14,39 @@
  **   3) Loops (edges from a vertex to itself) are forbidden
  **   4) Non-existent edges are represented by the empty string
  **   5) Artists with the empty string as their name are forbidden 
+ **   6) Each edge keeps every song the two artists share. Song titles are
+ **      stored once and given song IDs; an edge is a run of song IDs in one
+ **      shared pool, and its strength is the length of that run
+ **   7) Vertices, adjacency lists, artist names, song titles and the name
+ **      maps all live in the graph's Arena, so the graph is built from a few
+ **      large blocks and torn down by releasing them. The arena is on the
+ **      heap, so moving a graph is trading a few pointers and arrays.
+ **   8) compress() re-encodes every adjacency list as variable-length
+ **      deltas in one byte array, about a quarter of the size. Neighbors are
+ **      decoded on the fly by the Neighbors iterator, which every traversal
+ **      uses, and they keep their order, so searches find the same paths.
+ **      A compressed graph cannot gain edges.
+ **   9) save() writes a compressed graph to a GraphFile and open_file()
+ **      maps one back in read-only, so the adjacency lists, names and
+ **      titles are read from the mapping, paged in as searches reach them,
+ **      instead of being held in memory. A mapped graph cannot change.
+ **  10) normalize_names() makes the name maps key on each name's NameFold
+ **      form, so spellings that differ only in case, accents typed apart
+ **      from their letters, curly quotes or dashes are one vertex or one
+ **      song. The first spelling interned is the one kept and shown. A
+ **      mapped graph looks names up exactly as they were saved.
+ **  11) copying a graph copies it whole, ID by ID: each vertex record and
+ **      adjacency list is copied in one piece, the song pool and compressed
+ **      lists as whole arrays, and the name maps are rebuilt at their final
+ **      size. A copy of a mapped graph shares its source's mapping, so it
+ **      reads the same file even if that file was replaced since.
+ **  12) a fork (the constructor taking a shared_ptr) is a copy on write of
+ **      a graph that no longer changes. It starts with the base's vertex
+ **      pointers, titles and song pool, and shares the vertices, names,
+ **      adjacency lists and name maps; a vertex's record and list are
+ **      copied into the fork's arena the first time the fork changes them,
+ **      and names the fork adds go in maps of its own, looked up before the
+ **      base's. renumber() copies whatever is still shared first.
  **
  **/
 
@@ -21,11 +54,20 @@
 #define __COLLAB_GRAPH__
 
 #include <iostream>
+#include <memory>
 #include <stack>
 #include <vector>
 #include <unordered_map>
+#include <memory_resource>
+#include <string_view>
+#include <cstdint>
 
+#include "Arena.h"
+#include "GraphFile.h"
+#include "NameHash.h"
 #include "Artist.h"
+#include "SearchState.h"
+#include "VertexSet.h"
 
 class CollabGraph {
 
@@ -38,10 +80,23 @@ public:
     CollabGraph(const CollabGraph &source);
     CollabGraph &operator=(const CollabGraph &rhs);
 
+    /* Moves trade contents in constant time (see the move assignment) */
+    CollabGraph(CollabGraph &&source);
+    CollabGraph &operator=(CollabGraph &&rhs);
+
+    /* A copy on write of a graph that no longer changes (see note 12) */
+    explicit CollabGraph(std::shared_ptr<const CollabGraph> base);
+
     /* Mutators */
     void insert_vertex(const Artist &artist);
     void insert_edge(const Artist &a1, const Artist &a2,
                      const std::string &song);
+    void insert_edge(size_t id1, size_t id2, const std::vector<size_t> &songs);
+    size_t intern_song(std::string_view song);
+    void normalize_names(bool on);
+    void renumber(const std::vector<size_t> &order);
+    void compress();
+    void open_file(const std::string &path);
     void mark_vertex(const Artist &artist);
     void unmark_vertex(const Artist &artist);
     void set_predecessor(const Artist &to, const Artist &from);
@@ -52,36 +107,213 @@ public:
     bool                is_marked(const Artist &artist) const;
     Artist              get_predecessor(const Artist &artist) const;
     std::string         get_edge(const Artist &a1, const Artist &a2) const;
+    std::vector<std::string> get_songs(const Artist &a1,
+                                       const Artist &a2) const;
     std::vector<Artist> get_vertex_neighbors(const Artist &artist) const;
     std::stack<Artist>  report_path(const Artist &source,
                                     const Artist &dest) const;
     void                print_graph(std::ostream &out);
+    void                save(const std::string &path) const;
+
+    /* Vertex IDs: dense indices handed out in insertion order.
+     * These accessors never touch the graph's own traversal metadata, so
+     * any number of threads may call them at once, each searching with its
+     * own SearchState. */
+    static const size_t NO_VERTEX = SearchState::NO_VERTEX;
+
+    size_t              vertex_count() const;
+    size_t              get_vertex_id(const Artist &artist) const;
+    size_t              find_vertex(const std::string &name) const;
+    Artist              get_vertex(size_t id) const;
+    std::string         get_name(size_t id) const;
+    std::string_view    name_view(size_t id) const;
+    size_t              degree(size_t id) const;
+    size_t              get_neighbor(size_t id, size_t i) const;
+    size_t              get_neighbor_strength(size_t id, size_t i) const;
+    bool                is_compressed() const;
+    bool                is_mapped() const;
+    bool                is_normalized() const;
+    bool                is_fork() const;
+
+    /* Bytes held by each part of the graph, for capacity planning */
+    struct Memory {
+        size_t names;       /* artist names, song titles and their keys */
+        size_t maps;        /* the name maps' entries and buckets */
+        size_t vertices;    /* vertex records and the ID tables */
+        size_t adjacency;   /* the plain lists, or the compressed bytes */
+        size_t pool;        /* the song ID runs of the edges */
+        size_t slack;       /* arena bytes none of the above use */
+        size_t mapped;      /* a mapped graph file, paged in as read */
+        size_t metadata;    /* marks and predecessors of the Artist API */
+    };
+    Memory              memory() const;
+
+    /* Walks the edges of one vertex in order; see the end of the class */
+    class Neighbors;
+    Neighbors           neighbors(size_t id) const;
+    std::string         get_edge(size_t id1, size_t id2) const;
+    size_t              get_strength(size_t id1, size_t id2) const;
+    std::vector<size_t> get_song_ids(size_t id1, size_t id2) const;
+
+    /* Song IDs: dense indices for the distinct song titles */
+    static const size_t NO_SONG = (size_t) -1;
+
+    size_t              song_count() const;
+    std::string         get_song(size_t songId) const;
+    std::string_view    song_view(size_t songId) const;
+    size_t              find_song(const std::string &title) const;
 
 private:
+    /* Both directions of an edge point at the same run of song IDs */
     struct Edge {
-        Edge(Artist a, std::string s) {
-            neighbor = a; 
-            song = s; 
+        Edge(size_t n, size_t f, size_t c) {
+            neighbor = n; 
+            first = f; 
+            strength = c;
         };
-        Artist neighbor;
-        std::string song;
+        size_t neighbor; /* vertex ID */
+        size_t first;    /* start of the edge's run in 'songPool' */
+        size_t strength; /* length of the run: songs the two artists share */
     };
 
+    /* Made in the arena and never destroyed: the name and the adjacency
+     * list's buffer are in the arena too */
     struct Vertex {
-        Vertex() {};
-        Vertex(Artist a) { artist = a; };
-
-        Artist artist;
-        std::vector<Edge> neighbors;
+        Vertex(std::string_view n, Arena *arena) : neighbors(arena) {
+            name = n;
+        };
 
-        Vertex *predecessor = nullptr;
-        bool visited = false;
+        std::string_view name;
+        std::pmr::vector<Edge> neighbors;
+        size_t id = 0;
     };
 
     void self_destruct();
+    void make_maps();
+    void copy_from(const CollabGraph &source);
+    Vertex *own(size_t id);
+    void detach();
     void enforce_valid_vertex(const Artist &artist) const;
+    void enforce_valid_id(size_t id) const;
+    void enforce_unmapped() const;
+    void enforce_uncompressed() const;
+    std::string_view name_of(size_t id) const;
+    std::string_view title_of(size_t songId) const;
+    std::string_view key_of(std::string_view name, std::string &scratch) const;
+    std::string_view stored_key(std::string_view stored);
+    const uint32_t  *song_runs() const;
+    bool find_edge(size_t id1, size_t id2, size_t &first,
+                   size_t &strength) const;
+    void add_songs(size_t id1, size_t id2, const std::vector<size_t> &add);
+
+    static void     write_varint(std::vector<uint8_t> &out, uint64_t value);
+    static uint64_t read_varint(const uint8_t *&at)
+    {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            uint8_t byte = *at++;
+            value |= (uint64_t) (byte & 0x7F) << shift;
+            if (byte < 0x80) return value;
+        }
+    }
+
+    typedef std::pmr::unordered_map<std::string_view, Vertex *, NameHash>
+        VertexMap;
+    typedef std::pmr::unordered_map<std::string_view, size_t, NameHash>
+        SongMap;
+
+    /* the arena is on the heap and the name maps are made in it (see
+     * make_maps), so moving a graph moves pointers and nothing in the arena
+     * needs a new address */
+    std::unique_ptr<Arena> arena;
 
-    std::unordered_map<std::string, Vertex *> graph;
+    VertexMap            *graph;
+    std::vector<Vertex *> vertices; /* indexed by vertex ID */
+
+    std::vector<std::string_view> songs; /* indexed by song ID */
+    SongMap                      *songIds;
+    std::vector<uint32_t> songPool; /* the song ID runs of every edge */
+
+    /* the name maps key on NameFold forms (see normalize_names) */
+    bool normalized = false;
+
+    /* compressed adjacency: vertex i's edges start at packed[packedStart[i]]
+     * with its degree, then per edge the change in neighbor ID, the strength
+     * and the change in song run start (see compress) */
+    bool                  compressed = false;
+    std::vector<uint8_t>  packed;
+    std::vector<uint64_t> packedStart;
+
+    /* a saved graph mapped by open_file(), which replaces everything above
+     * but the arena */
+    GraphFile file;
+
+    /* a fork's base, and what it still shares with it: by vertex ID, whether
+     * the vertex is still the base's, and how many titles (the first ones)
+     * are still in the base's arena */
+    std::shared_ptr<const CollabGraph> base;
+    std::vector<bool>                  borrowed;
+    size_t                             borrowedSongs = 0;
+
+    /* marks and predecessors for the Artist-based traversal functions */
+    SearchState metadata;
+
+public:
+    /* The neighbor iterator:
+     *
+     *     CollabGraph::Neighbors edge = graph.neighbors(id);
+     *     while (edge.next()) { ... edge.neighbor() ... }
+     *
+     * It reads the plain adjacency list or decodes the compressed one as it
+     * goes; next() is defined here so the traversals can inline it. It is
+     * only valid while the graph is not changed. */
+    class Neighbors {
+    public:
+        bool next()
+        {
+            if (not compressed) {
+                if (plain == plainEnd) return false;
+                id = plain->neighbor;
+                first = plain->first;
+                count = plain->strength;
+                plain++;
+                return true;
+            }
+            if (left == 0) return false;
+            left--;
+            id += unzigzag(read_varint(at));
+            count = read_varint(at);
+            first = first + lastCount + unzigzag(read_varint(at));
+            lastCount = count;
+            return true;
+        }
+
+        size_t neighbor() const { return id; }
+        size_t strength() const { return count; }
+        size_t first_song() const { return pool[first]; }
+        size_t open_song(const VertexSet &blocked) const;
+        size_t open_songs(const VertexSet &blocked) const;
+
+    private:
+        friend class CollabGraph;
+
+        static int64_t unzigzag(uint64_t value)
+        {
+            return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+        }
+
+        const uint32_t *pool;       /* the song ID runs */
+        bool           compressed;
+        const Edge    *plain;       /* plain: the next edge, and the end */
+        const Edge    *plainEnd;
+        const uint8_t *at;          /* compressed: the next byte to decode */
+        size_t         left;        /* compressed: edges not yet decoded */
+        size_t         lastCount;   /* compressed: the previous strength */
+
+        size_t id;                  /* the current edge */
+        size_t first;
+        size_t count;
+    };
 };
 
 #endif /* __COLLAB_GRAPH__ */
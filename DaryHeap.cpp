@@ -0,0 +1,206 @@
+/**
+ ** DaryHeap.cpp
+ **
+ ** Purpose:
+ **   An indexed 4-ary min-heap of vertex IDs keyed by cost.
+ **   See DaryHeap.h
+ **
+ **/
+
+#include "DaryHeap.h"
+
+using namespace std;
+
+const size_t DaryHeap::ARITY;
+const size_t DaryHeap::ABSENT;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: nullary constructor
+ * @purpose: initialize an empty queue; resize() must be called with the
+ *           size of the graph before anything is pushed
+ */
+DaryHeap::DaryHeap()
+{
+
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * resize
+ * purpose: make room for the vertex IDs of a graph with 'vertexCount'
+ *          vertices
+ *
+ * parameters: the number of vertices in the graph
+ * returns: none
+ */
+void DaryHeap::resize(size_t vertexCount)
+{
+    if (position.size() < vertexCount) position.resize(vertexCount, ABSENT);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * clear
+ * purpose: empty the queue
+ *
+ * parameters: none
+ * returns: none
+ */
+void DaryHeap::clear()
+{
+    for (size_t i = 0; i < nodes.size(); i++) {
+        position[nodes[i].id] = ABSENT;
+    }
+    nodes.clear();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * push
+ * purpose: queue a vertex with the given cost, or lower the cost of a vertex
+ *          that is already queued
+ *
+ * parameters: a vertex ID and its cost
+ * returns: none
+ * note: does nothing if the vertex is queued with a cost that is not higher
+ */
+void DaryHeap::push(size_t id, double cost)
+{
+    size_t slot = position[id];
+    if (slot == ABSENT) {
+        nodes.push_back(Node{cost, id});
+        position[id] = nodes.size() - 1;
+        sift_up(nodes.size() - 1);
+    } else if (cost < nodes[slot].cost) {
+        nodes[slot].cost = cost;
+        sift_up(slot);
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * pop
+ * purpose: remove the vertex with the lowest cost
+ *
+ * preconditions: the queue is not empty
+ * parameters: none
+ * returns: the vertex ID that was removed
+ */
+size_t DaryHeap::pop()
+{
+    size_t top = nodes[0].id;
+    position[top] = ABSENT;
+
+    Node last = nodes.back();
+    nodes.pop_back();
+    if (not nodes.empty()) {
+        place(0, last);
+        sift_down(0);
+    }
+    return top;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * empty / size / contains / bytes
+ * purpose: report on what is queued, and the memory the queue holds
+ */
+bool DaryHeap::empty() const
+{
+    return nodes.empty();
+}
+
+size_t DaryHeap::size() const
+{
+    return nodes.size();
+}
+
+bool DaryHeap::contains(size_t id) const
+{
+    return id < position.size() and position[id] != ABSENT;
+}
+
+size_t DaryHeap::bytes() const
+{
+    return nodes.capacity() * sizeof(Node) +
+           position.capacity() * sizeof(size_t);
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * sift_up
+ * purpose: move the node in 'slot' toward the root until its parent costs
+ *          no more than it does
+ */
+void DaryHeap::sift_up(size_t slot)
+{
+    Node node = nodes[slot];
+    while (slot > 0) {
+        size_t parent = (slot - 1) / ARITY;
+        if (nodes[parent].cost <= node.cost) break;
+        place(slot, nodes[parent]);
+        slot = parent;
+    }
+    place(slot, node);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * sift_down
+ * purpose: move the node in 'slot' toward the leaves until none of its
+ *          children cost less than it does
+ */
+void DaryHeap::sift_down(size_t slot)
+{
+    Node node = nodes[slot];
+    size_t count = nodes.size();
+
+    while (true) {
+        size_t first = slot * ARITY + 1;
+        if (first >= count) break;
+
+        /* the children are contiguous, so this scan stays in one line */
+        size_t best = first;
+        size_t last = first + ARITY < count ? first + ARITY : count;
+        for (size_t child = first + 1; child < last; child++) {
+            if (nodes[child].cost < nodes[best].cost) best = child;
+        }
+        if (node.cost <= nodes[best].cost) break;
+
+        place(slot, nodes[best]);
+        slot = best;
+    }
+    place(slot, node);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * place
+ * purpose: store a node in a slot and remember where it went
+ */
+void DaryHeap::place(size_t slot, const Node &node)
+{
+    nodes[slot] = node;
+    position[node.id] = slot;
+}
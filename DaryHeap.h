@@ -0,0 +1,61 @@
+/**
+ ** DaryHeap.h
+ **
+ ** Purpose:
+ **   An indexed min-priority queue of vertex IDs keyed by cost, used by the
+ **   weighted (Dijkstra) searches. It is a 4-ary heap: each node has four
+ **   children stored next to each other, so sifting down touches one cache
+ **   line per level and the tree is half as deep as a binary heap.
+ **
+ ** Notes:
+ **   1) a vertex is in the queue at most once; pushing it again with a
+ **      lower cost moves it up (decrease-key) instead of adding a copy
+ **   2) the position of each vertex is kept in an array indexed by vertex
+ **      ID, so the queue is sized to the graph with resize()
+ **   3) clear() only touches the vertices still queued, so one queue can be
+ **      reused for search after search without an O(V) wipe
+ **
+ **/
+
+#ifndef __DARY_HEAP__
+#define __DARY_HEAP__
+
+#include <cstddef>
+#include <vector>
+
+class DaryHeap {
+
+public:
+    DaryHeap();
+
+    void resize(size_t vertexCount);
+    void clear();
+
+    /* Mutators */
+    void   push(size_t id, double cost);
+    size_t pop();
+
+    /* Accessors */
+    bool   empty() const;
+    size_t size() const;
+    bool   contains(size_t id) const;
+    size_t bytes() const;
+
+private:
+    static const size_t ARITY = 4;
+    static const size_t ABSENT = (size_t) -1;
+
+    struct Node {
+        double cost;
+        size_t id;
+    };
+
+    void sift_up(size_t slot);
+    void sift_down(size_t slot);
+    void place(size_t slot, const Node &node);
+
+    std::vector<Node>   nodes;
+    std::vector<size_t> position;   /* slot in 'nodes', or ABSENT */
+};
+
+#endif /* __DARY_HEAP__ */
@@ -0,0 +1,190 @@
+/**
+ ** GraphBuilder.cpp
+ **
+ ** Purpose:
+ **   Streaming construction of a CollabGraph from the data file.
+ **   See GraphBuilder.h
+ **
+ **/
+
+#include <string>
+
+#include "Artist.h"
+#include "GraphBuilder.h"
+
+using namespace std;
+
+const size_t GraphBuilder::DEFAULT_MEMORY;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: constructor
+ * @purpose: get ready to build into an empty graph
+ *
+ * @parameters: 1) the graph to build, which should be empty
+ *              2) about how many bytes the two sorts may hold in memory
+ *                 before they spill to temporary files
+ */
+GraphBuilder::GraphBuilder(CollabGraph &g, size_t memoryBytes)
+    : graph(g), postings(memoryBytes / 2 / sizeof(Posting)),
+      pairs(memoryBytes / 2 / sizeof(Pair))
+{
+    rank = 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * add_artist
+ * purpose: start the next artist record of the data file
+ *
+ * parameters: the artist's name
+ * returns:    none
+ *
+ * notes: throws a runtime_error if the name is empty (see insert_vertex)
+ */
+void GraphBuilder::add_artist(string_view name)
+{
+    Artist artist{string(name)};
+    graph.insert_vertex(artist);
+    vertexOf.push_back(graph.get_vertex_id(artist));
+    rank = 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * add_song
+ * purpose: add a song to the current artist record
+ *
+ * parameters: the song's title
+ * returns:    none
+ *
+ * notes: 1) the title is interned right away, so song IDs are handed out
+ *           in file order; only the song ID is kept
+ *        2) throws a runtime_error if the title is empty (see intern_song);
+ *           a song before any artist is ignored
+ */
+void GraphBuilder::add_song(string_view title)
+{
+    size_t song = graph.intern_song(title);
+    if (vertexOf.empty()) return;
+    postings.push(Posting{(uint32_t) song, (uint32_t) (vertexOf.size() - 1),
+                          rank++});
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * finish
+ * purpose: insert every edge, once the whole file has been added
+ *
+ * parameters: none
+ * returns:    none
+ *
+ * notes: the postings come back grouped by song, each group in place
+ *        order, so every song's artists are paired up one group at a time.
+ *        The pairs come back grouped by edge in the order the edges are
+ *        inserted, each with its songs in the first artist's order.
+ */
+void GraphBuilder::finish()
+{
+    postings.finish();
+    vector<Posting> singers;
+    Posting posting;
+    while (postings.next(posting)) {
+        if (not singers.empty() and singers.back().song != posting.song) {
+            pair_up(singers);
+            singers.clear();
+        }
+        if (not singers.empty() and singers.back().place == posting.place) {
+            continue; //listed twice by one artist, the first one counts
+        }
+        singers.push_back(posting);
+    }
+    pair_up(singers);
+
+    pairs.finish();
+    vector<size_t> shared;
+    Pair pair = Pair(), last = Pair();
+    while (pairs.next(pair)) {
+        if (not shared.empty() and
+            (pair.first != last.first or pair.second != last.second)) {
+            graph.insert_edge(vertexOf[last.first], vertexOf[last.second],
+                              shared);
+            shared.clear();
+        }
+        shared.push_back(pair.song);
+        last = pair;
+    }
+    if (not shared.empty()) {
+        graph.insert_edge(vertexOf[last.first], vertexOf[last.second],
+                          shared);
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * places
+ * purpose: map artist records to vertices
+ *
+ * parameters: none
+ * returns:    the vertex ID of each artist record, in data file order
+ */
+const vector<size_t> &GraphBuilder::places() const
+{
+    return vertexOf;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * spills
+ * purpose: report whether the load outgrew its memory
+ *
+ * parameters: none
+ * returns:    how many sorted runs were written to temporary files
+ */
+size_t GraphBuilder::spills() const
+{
+    return postings.spills() + pairs.spills();
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * pair_up
+ * purpose: queue the song of a group of postings for every pair of the
+ *          artists who sang it
+ *
+ * parameters: the postings of one song, in place order, one per place
+ * returns:    none
+ *
+ * notes: two records of the same artist are the same vertex and get no
+ *        edge
+ */
+void GraphBuilder::pair_up(const vector<Posting> &singers)
+{
+    for (size_t a = 0; a < singers.size(); a++) {
+        for (size_t b = a + 1; b < singers.size(); b++) {
+            if (vertexOf[singers[a].place] == vertexOf[singers[b].place]) {
+                continue;
+            }
+            pairs.push(Pair{singers[a].place, singers[b].place,
+                            singers[a].rank, singers[a].song});
+        }
+    }
+}
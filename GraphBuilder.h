@@ -0,0 +1,90 @@
+/**
+ ** GraphBuilder.h
+ **
+ ** Purpose:
+ **   Builds a CollabGraph from the data file one record at a time, without
+ **   ever holding the artists' discographies. Each song line becomes a
+ **   posting (song ID, which artist record sang it) pushed into an external
+ **   sort; sorting them by song lines up the artists who share each song,
+ **   and the pairs of them go through a second external sort that lines the
+ **   edges up in the order they are inserted. The memory used while
+ **   loading is the graph itself plus the two sort buffers, however big the
+ **   data file is.
+ **
+ ** Notes:
+ **   1) the graph comes out exactly as the old load-everything-then-compare
+ **      loader made it: vertices and song IDs in file order, and each edge
+ **      inserted in artist order with the songs the two share in the order
+ **      the first of them listed them
+ **   2) a song listed twice by the same artist counts once, and two records
+ **      with the same artist name are the same vertex
+ **   3) places are the positions of the artist records in the data file,
+ **      which places() maps to vertex IDs
+ **
+ **/
+
+#ifndef __GRAPH_BUILDER__
+#define __GRAPH_BUILDER__
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "CollabGraph.h"
+#include "SpillSorter.h"
+
+class GraphBuilder {
+
+public:
+    static const size_t DEFAULT_MEMORY = 256u << 20;
+
+    GraphBuilder(CollabGraph &graph, size_t memoryBytes = DEFAULT_MEMORY);
+
+    /* Mutators, in data file order */
+    void add_artist(std::string_view name);
+    void add_song(std::string_view title);
+    void finish();
+
+    /* Accessors */
+    const std::vector<size_t> &places() const;
+    size_t                     spills() const;
+
+private:
+    /* one song line: record 'place' listed 'song' as its 'rank'-th song */
+    struct Posting {
+        uint32_t song;
+        uint32_t place;
+        uint32_t rank;
+        bool operator<(const Posting &other) const
+        {
+            if (song != other.song) return song < other.song;
+            if (place != other.place) return place < other.place;
+            return rank < other.rank;
+        }
+    };
+
+    /* a song the records 'first' < 'second' share, 'rank'-th in first's */
+    struct Pair {
+        uint32_t first;
+        uint32_t second;
+        uint32_t rank;
+        uint32_t song;
+        bool operator<(const Pair &other) const
+        {
+            if (first != other.first) return first < other.first;
+            if (second != other.second) return second < other.second;
+            return rank < other.rank;
+        }
+    };
+
+    void pair_up(const std::vector<Posting> &singers);
+
+    CollabGraph          &graph;
+    std::vector<size_t>   vertexOf;     /* vertex ID of each place */
+    uint32_t              rank;         /* songs so far in this record */
+    SpillSorter<Posting>  postings;
+    SpillSorter<Pair>     pairs;
+};
+
+#endif /* __GRAPH_BUILDER__ */
@@ -0,0 +1,426 @@
+/**
+ ** GraphExport.cpp
+ **
+ ** Purpose:
+ **   Streaming export of a CollabGraph to standard formats.
+ **   See GraphExport.h
+ **
+ **/
+
+#include <charconv>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "GraphExport.h"
+
+using namespace std;
+
+const size_t GraphExport::BUFFER_SIZE;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * parse_format
+ * purpose: read the name of an export format
+ *
+ * parameters: the name (edges, names, csr, graphml or dot) and where to
+ *             put the format
+ * returns:    false if the name is not a format
+ */
+bool GraphExport::parse_format(const string &name, Format &format)
+{
+    if (name == "edges") format = Format::EDGES;
+    else if (name == "names") format = Format::NAMES;
+    else if (name == "csr") format = Format::CSR;
+    else if (name == "graphml") format = Format::GRAPHML;
+    else if (name == "dot") format = Format::DOT;
+    else return false;
+    return true;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * write
+ * purpose: export a graph to a file
+ *
+ * parameters: the graph, the format and the file's name; a name ending in
+ *             ".gz" is compressed with gzip
+ * returns:    none
+ *
+ * notes: throws a runtime_error if the file cannot be written or gzip
+ *        fails, after removing what was written of it
+ */
+void GraphExport::write(const CollabGraph &graph, Format format,
+                        const string &path)
+{
+    GraphExport out(path);
+    if (format == Format::EDGES) out.write_edges(graph);
+    else if (format == Format::NAMES) out.write_names(graph);
+    else if (format == Format::CSR) out.write_csr(graph);
+    else if (format == Format::GRAPHML) out.write_graphml(graph);
+    else out.write_dot(graph);
+    out.finish();
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: constructor
+ * @purpose: open the file, starting gzip on it if its name ends in ".gz"
+ *
+ * @parameters: the file's name
+ *
+ * @notes: gzip reads a pipe and writes the file itself; both ends are
+ *         closed on exec, so gzip only holds the ones it was handed
+ */
+GraphExport::GraphExport(const string &name)
+    : path(name), fd(-1), compressor(0), buffer(BUFFER_SIZE), used(0)
+{
+    int file = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (file < 0) {
+        string message = path + " cannot be written";
+        throw runtime_error(message.c_str());
+    }
+    bool gzip = path.size() > 3 and
+                path.compare(path.size() - 3, 3, ".gz") == 0;
+    if (not gzip) {
+        fd = file;
+        return;
+    }
+
+    int ends[2];
+    if (pipe2(ends, O_CLOEXEC) < 0 or (compressor = fork()) < 0) {
+        close(file);
+        unlink(path.c_str());
+        string message = "cannot start gzip for " + path;
+        throw runtime_error(message.c_str());
+    }
+    if (compressor == 0) {
+        dup2(ends[0], STDIN_FILENO);
+        dup2(file, STDOUT_FILENO);
+        execlp("gzip", "gzip", "-1", "-c", (char *) nullptr);
+        _exit(127);
+    }
+    close(ends[0]);
+    close(file);
+    fd = ends[1];
+    signal(SIGPIPE, SIG_IGN); //a gzip that died fails the next write instead
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: destructor
+ * @purpose: if the export did not finish, stop gzip and remove the file
+ */
+GraphExport::~GraphExport()
+{
+    if (fd < 0 and compressor == 0) return;
+    if (fd >= 0) close(fd);
+    if (compressor > 0) waitpid(compressor, nullptr, 0);
+    unlink(path.c_str());
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * write_edges / write_names
+ * purpose: the edge list, each edge once from its lower ID, and the names
+ *          in ID order
+ *
+ * parameters: the graph
+ * returns:    none
+ */
+void GraphExport::write_edges(const CollabGraph &graph)
+{
+    for (size_t id = 0; id < graph.vertex_count(); id++) {
+        CollabGraph::Neighbors edge = graph.neighbors(id);
+        while (edge.next()) {
+            if (edge.neighbor() < id) continue;
+            put(id);
+            put("\t");
+            put(edge.neighbor());
+            put("\t");
+            put(edge.strength());
+            put("\n");
+        }
+    }
+}
+
+void GraphExport::write_names(const CollabGraph &graph)
+{
+    for (size_t id = 0; id < graph.vertex_count(); id++) {
+        put(graph.name_view(id));
+        put("\n");
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * write_csr
+ * purpose: the binary compressed sparse rows (see GraphExport.h)
+ *
+ * parameters: the graph
+ * returns:    none
+ *
+ * notes: the row starts come from the degrees alone; the neighbors and the
+ *        strengths are two more passes over the lists, so each array is
+ *        written in order without being held
+ */
+void GraphExport::write_csr(const CollabGraph &graph)
+{
+    size_t count = graph.vertex_count();
+    uint64_t entries = 0;
+    for (size_t id = 0; id < count; id++) entries += graph.degree(id);
+    if (count > UINT32_MAX) {
+        fail("too many artists for 32 bit neighbor IDs");
+    }
+
+    const char magic[8] = {'6', 'D', 'E', 'G', 'C', 'S', 'R', '1'};
+    const uint32_t mark[2] = {0x01020304, 0};
+    const uint64_t counts[2] = {count, entries};
+    put_raw(magic, sizeof(magic));
+    put_raw(mark, sizeof(mark));
+    put_raw(counts, sizeof(counts));
+
+    uint64_t start = 0;
+    for (size_t id = 0; id < count; id++) {
+        put_raw(&start, sizeof(start));
+        start += graph.degree(id);
+    }
+    put_raw(&start, sizeof(start));
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t id = 0; id < count; id++) {
+            CollabGraph::Neighbors edge = graph.neighbors(id);
+            while (edge.next()) {
+                uint32_t value = pass == 0 ? edge.neighbor()
+                                           : edge.strength();
+                put_raw(&value, sizeof(value));
+            }
+        }
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * write_graphml / write_dot
+ * purpose: the graph as GraphML or as Graphviz's dot language, each edge
+ *          once from its lower ID
+ *
+ * parameters: the graph
+ * returns:    none
+ */
+void GraphExport::write_graphml(const CollabGraph &graph)
+{
+    put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+        "  <key id=\"name\" for=\"node\" attr.name=\"name\" "
+        "attr.type=\"string\"/>\n"
+        "  <key id=\"weight\" for=\"edge\" attr.name=\"weight\" "
+        "attr.type=\"int\"/>\n"
+        "  <graph id=\"collaborations\" edgedefault=\"undirected\">\n");
+    for (size_t id = 0; id < graph.vertex_count(); id++) {
+        put("    <node id=\"n");
+        put(id);
+        put("\"><data key=\"name\">");
+        put_escaped(graph.name_view(id), true);
+        put("</data></node>\n");
+    }
+    for (size_t id = 0; id < graph.vertex_count(); id++) {
+        CollabGraph::Neighbors edge = graph.neighbors(id);
+        while (edge.next()) {
+            if (edge.neighbor() < id) continue;
+            put("    <edge source=\"n");
+            put(id);
+            put("\" target=\"n");
+            put(edge.neighbor());
+            put("\"><data key=\"weight\">");
+            put(edge.strength());
+            put("</data></edge>\n");
+        }
+    }
+    put("  </graph>\n</graphml>\n");
+}
+
+void GraphExport::write_dot(const CollabGraph &graph)
+{
+    put("graph collaborations {\n");
+    for (size_t id = 0; id < graph.vertex_count(); id++) {
+        put("  ");
+        put(id);
+        put(" [label=\"");
+        put_escaped(graph.name_view(id), false);
+        put("\"];\n");
+    }
+    for (size_t id = 0; id < graph.vertex_count(); id++) {
+        CollabGraph::Neighbors edge = graph.neighbors(id);
+        while (edge.next()) {
+            if (edge.neighbor() < id) continue;
+            put("  ");
+            put(id);
+            put(" -- ");
+            put(edge.neighbor());
+            put(" [weight=");
+            put(edge.strength());
+            put("];\n");
+        }
+    }
+    put("}\n");
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * put / put_raw
+ * purpose: append text, a number in decimal, or raw bytes to the buffer,
+ *          writing the buffer out whenever it fills
+ *
+ * parameters: what to append
+ * returns:    none
+ */
+void GraphExport::put(string_view text)
+{
+    put_raw(text.data(), text.size());
+}
+
+void GraphExport::put(uint64_t number)
+{
+    if (buffer.size() - used < 20) flush(); //the most digits a uint64 has
+    char *at = buffer.data() + used;
+    used = to_chars(at, at + 20, number).ptr - buffer.data();
+}
+
+void GraphExport::put_raw(const void *data, size_t bytes)
+{
+    const char *from = (const char *) data;
+    while (bytes > 0) {
+        if (used == buffer.size()) flush();
+        size_t take = min(bytes, buffer.size() - used);
+        memcpy(buffer.data() + used, from, take);
+        used += take;
+        from += take;
+        bytes -= take;
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * put_escaped
+ * purpose: append a name inside an XML element or a dot string
+ *
+ * parameters: the name, and true for XML
+ * returns:    none
+ *
+ * notes: XML escapes &, < and > and drops the control characters XML 1.0
+ *        forbids; dot escapes " and \ with a backslash. Runs of ordinary
+ *        bytes are appended whole.
+ */
+void GraphExport::put_escaped(string_view text, bool xml)
+{
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = text[i];
+        const char *escape = nullptr;
+        if (xml) {
+            if (c == '&') escape = "&amp;";
+            else if (c == '<') escape = "&lt;";
+            else if (c == '>') escape = "&gt;";
+            else if (c < 0x20 and c != '\t') escape = "";
+        } else {
+            if (c == '"') escape = "\\\"";
+            else if (c == '\\') escape = "\\\\";
+        }
+        if (escape == nullptr) continue;
+        put(text.substr(run, i - run));
+        put(escape);
+        run = i + 1;
+    }
+    put(text.substr(run));
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * flush
+ * purpose: write out everything in the buffer
+ *
+ * parameters: none
+ * returns:    none
+ */
+void GraphExport::flush()
+{
+    size_t done = 0;
+    while (done < used) {
+        ssize_t wrote = ::write(fd, buffer.data() + done, used - done);
+        if (wrote < 0 and errno == EINTR) continue;
+        if (wrote <= 0) fail(path + " could not be written completely");
+        done += wrote;
+    }
+    used = 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * finish
+ * purpose: write out the rest, close the file and wait for gzip
+ *
+ * parameters: none
+ * returns:    none
+ */
+void GraphExport::finish()
+{
+    flush();
+    int closed = close(fd);
+    fd = -1;
+    if (closed < 0) fail(path + " could not be written completely");
+    if (compressor > 0) {
+        int status = 0;
+        pid_t waited = waitpid(compressor, &status, 0);
+        compressor = 0;
+        if (waited < 0 or not WIFEXITED(status) or WEXITSTATUS(status) != 0) {
+            fail("gzip could not write " + path);
+        }
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * fail
+ * purpose: give up on the export
+ *
+ * parameters: what went wrong
+ * returns:    never; throws a runtime_error, and the destructor then
+ *             removes the file
+ */
+void GraphExport::fail(const string &why)
+{
+    if (fd < 0 and compressor == 0) { //already closed: remove it here
+        unlink(path.c_str());
+    }
+    throw runtime_error(why.c_str());
+}
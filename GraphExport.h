@@ -0,0 +1,87 @@
+/**
+ ** GraphExport.h
+ **
+ ** Purpose:
+ **   Writes a CollabGraph out for other tools, in one of these formats:
+ **     - edges:   one line per edge, "id1<TAB>id2<TAB>strength", with
+ **                id1 < id2, in vertex ID order
+ **     - names:   one artist name per line, in vertex ID order, to go with
+ **                the edge list (or the CSR dump)
+ **     - csr:     compressed sparse rows in binary: a header, then every
+ **                vertex's first entry (V + 1 uint64s), then the neighbor
+ **                IDs (uint32s), then the strengths (uint32s); each edge
+ **                is listed under both of its vertices
+ **     - graphml: GraphML, with each artist's "name" and each edge's
+ **                "weight" (its strength)
+ **     - dot:     a Graphviz undirected graph, labeled with the names and
+ **                weighted with the strengths
+ **   A path ending in ".gz" is written through gzip -1, in a process of
+ **   its own, so compressing runs alongside the formatting.
+ **
+ ** Notes:
+ **   1) the graph is streamed: each adjacency list is walked in place with
+ **      the Neighbors iterator and formatted straight into a buffer of a
+ **      few megabytes, which is written whole, so nothing the size of the
+ **      graph is ever built and the file sees a few large writes
+ **   2) numbers are formatted with std::to_chars, not streams
+ **   3) the CSR header is the magic "6DEGCSR1", the machine's byte order
+ **      mark 0x01020304 and a zero (as uint32s), then the vertex and entry
+ **      counts (as uint64s); everything is in the machine's byte order
+ **   4) on any error the partial file is removed and a runtime_error is
+ **      thrown
+ **
+ **/
+
+#ifndef __GRAPH_EXPORT__
+#define __GRAPH_EXPORT__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "CollabGraph.h"
+
+class GraphExport {
+
+public:
+    enum class Format { EDGES, NAMES, CSR, GRAPHML, DOT };
+
+    static bool parse_format(const std::string &name, Format &format);
+    static void write(const CollabGraph &graph, Format format,
+                      const std::string &path);
+
+    GraphExport(const GraphExport &) = delete;
+    GraphExport &operator=(const GraphExport &) = delete;
+
+private:
+    static const size_t BUFFER_SIZE = 4 << 20;
+
+    GraphExport(const std::string &path);
+    ~GraphExport();
+
+    void write_edges(const CollabGraph &graph);
+    void write_names(const CollabGraph &graph);
+    void write_csr(const CollabGraph &graph);
+    void write_graphml(const CollabGraph &graph);
+    void write_dot(const CollabGraph &graph);
+
+    void put(std::string_view text);
+    void put(uint64_t number);
+    void put_raw(const void *data, size_t bytes);
+    void put_escaped(std::string_view text, bool xml);
+    void flush();
+    void finish();
+    void fail(const std::string &why);
+
+    std::string       path;
+    int               fd;           /* the file, or the pipe to gzip */
+    pid_t             compressor;   /* gzip's process, or 0 */
+    std::vector<char> buffer;
+    size_t            used;
+};
+
+#endif /* __GRAPH_EXPORT__ */
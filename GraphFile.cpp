@@ -0,0 +1,560 @@
+/**
+ ** GraphFile.cpp
+ **
+ ** Purpose:
+ **   Writing and memory-mapping saved collaboration graphs.
+ **   See GraphFile.h
+ **
+ **/
+
+#include <fstream>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "GraphFile.h"
+#include "NameHash.h"
+
+using namespace std;
+
+const size_t GraphFile::NOT_FOUND;
+const uint64_t GraphFile::MAGIC;
+const uint64_t GraphFile::ENDIAN_MARK;
+const uint32_t GraphFile::EMPTY;
+
+/* every section starts on a multiple of this */
+static uint64_t align8(uint64_t at)
+{
+    return (at + 7) & ~(uint64_t) 7;
+}
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: nullary constructor
+ * @purpose: initialize a GraphFile with nothing mapped; call open()
+ */
+GraphFile::GraphFile()
+{
+    base = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: destructor
+ * @purpose: unmap the file, if one is open
+ */
+GraphFile::~GraphFile()
+{
+    close();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * write
+ * purpose: save a graph to a file that open() can map
+ *
+ * parameters: the file to create (or replace) and what to put in it
+ * returns:    none
+ *
+ * notes: 1) the file is written front to back through a 1MB buffer, and
+ *           only the two hash tables are built in memory first
+ *        2) throws a runtime_error if the file cannot be written, or if
+ *           there are too many artists or songs for 32 bit IDs
+ *        3) the file is written under a temporary name in the same
+ *           directory and renamed over 'path' only once it is complete, so
+ *           a process that has the old file mapped keeps reading it, and a
+ *           failed write leaves the old file (or no file) behind; the
+ *           temporary file is removed on failure
+ */
+void GraphFile::write(const string &path, const Contents &contents)
+{
+    if (contents.names.size() >= EMPTY or contents.titles.size() >= EMPTY) {
+        string message = "too many artists or songs for a graph file";
+        throw runtime_error(message.c_str());
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MAGIC;
+    header.byteOrder = ENDIAN_MARK;
+    header.vertexCount = contents.names.size();
+    header.songCount = contents.titles.size();
+
+    /* Lay the sections out first, so the header can go in front. */
+    uint64_t at = align8(sizeof(Header));
+    header.adjacencyStarts = at;
+    at = align8(at + header.vertexCount * sizeof(uint64_t));
+    header.adjacency = at;
+    header.adjacencyBytes = contents.adjacencyBytes;
+    at = align8(at + contents.adjacencyBytes);
+    header.pool = at;
+    header.poolCount = contents.poolCount;
+    at = align8(at + contents.poolCount * sizeof(uint32_t));
+    at = layout_strings(contents.names, at, header.names);
+    at = layout_strings(contents.titles, at, header.titles);
+    header.fileBytes = at;
+
+    string temporary = path + ".tmp" + to_string(getpid());
+    vector<char> buffer(1 << 20);
+    ofstream out;
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    out.open(temporary, ios::out | ios::binary | ios::trunc);
+    if (not out.is_open()) {
+        string message = path + " cannot be written";
+        throw runtime_error(message.c_str());
+    }
+
+    try {
+        write_sections(out, header, contents);
+    } catch (...) {
+        out.close();
+        unlink(temporary.c_str());
+        throw;
+    }
+
+    out.close();
+    if (out.fail()) {
+        unlink(temporary.c_str());
+        string message = path + " could not be written completely";
+        throw runtime_error(message.c_str());
+    }
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        string message = path + " could not be replaced";
+        throw runtime_error(message.c_str());
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * write_sections
+ * purpose: write a laid out header and everything it describes, in order
+ *
+ * parameters: the open file, the header and what to put in the file
+ * returns:    none; a failed write shows in the stream's state
+ */
+void GraphFile::write_sections(ostream &out, const Header &header,
+                               const Contents &contents)
+{
+    uint64_t written = 0;
+    out.write((const char *) &header, sizeof(header));
+    written += sizeof(header);
+    pad(out, written, header.adjacencyStarts);
+    out.write((const char *) contents.adjacencyStarts,
+              header.vertexCount * sizeof(uint64_t));
+    written += header.vertexCount * sizeof(uint64_t);
+    pad(out, written, header.adjacency);
+    out.write((const char *) contents.adjacency, contents.adjacencyBytes);
+    written += contents.adjacencyBytes;
+    pad(out, written, header.pool);
+    out.write((const char *) contents.pool,
+              contents.poolCount * sizeof(uint32_t));
+    written += contents.poolCount * sizeof(uint32_t);
+    write_strings(out, contents.names, header.names, written);
+    write_strings(out, contents.titles, header.titles, written);
+    pad(out, written, header.fileBytes);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * is_graph_file
+ * purpose: tell a file written by write() from a text data file
+ *
+ * parameters: the name of a file
+ * returns:    true iff the file starts the way a graph file does
+ */
+bool GraphFile::is_graph_file(const string &path)
+{
+    ifstream in(path, ios::in | ios::binary);
+    uint64_t magic = 0;
+    in.read((char *) &magic, sizeof(magic));
+    return not in.fail() and magic == MAGIC;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * open
+ * purpose: map a file written by write(), read-only
+ *
+ * parameters: the name of the file
+ * returns:    none
+ *
+ * notes: 1) throws a runtime_error if the file cannot be opened or mapped,
+ *           or is not a graph file for this machine
+ *        2) the hash tables are looked up at random, so the kernel is told
+ *           not to read ahead in them; the rest is read with the default
+ *           readahead, which suits lists that are read front to back
+ */
+void GraphFile::open(const string &path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        string message = path + " cannot be opened";
+        throw runtime_error(message.c_str());
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 or (size_t) info.st_size < sizeof(Header)) {
+        ::close(fd);
+        string message = path + " is not a graph file";
+        throw runtime_error(message.c_str());
+    }
+
+    void *start = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); //the mapping keeps the file open
+    if (start == MAP_FAILED) {
+        string message = path + " cannot be mapped";
+        throw runtime_error(message.c_str());
+    }
+    size_t bytes = info.st_size;
+    mapping = shared_ptr<const uint8_t>((const uint8_t *) start,
+                                        [bytes](const uint8_t *at) {
+                                            munmap((void *) at, bytes);
+                                        });
+    base = mapping.get();
+    size = bytes;
+    header = (const Header *) base;
+
+    if (header->magic != MAGIC or header->byteOrder != ENDIAN_MARK or
+        header->fileBytes != size or
+        not fits(header->adjacencyStarts, header->vertexCount,
+                 sizeof(uint64_t)) or
+        not fits(header->adjacency, header->adjacencyBytes, 1) or
+        not fits(header->pool, header->poolCount, sizeof(uint32_t)) or
+        not fits(header->names, header->vertexCount) or
+        not fits(header->titles, header->songCount)) {
+        close();
+        string message = path + " is not a graph file for this machine";
+        throw runtime_error(message.c_str());
+    }
+
+    const Strings *tables[] = {&header->names, &header->titles};
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < 2; i++) {
+        uint64_t from = tables[i]->slots & ~(uint64_t) (page - 1);
+        uint64_t to = tables[i]->slots + tables[i]->slotCount *
+                                             sizeof(uint32_t);
+        madvise((void *) (base + from), to - from, MADV_RANDOM);
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * close
+ * purpose: let go of the mapping, which is unmapped once no other GraphFile
+ *          shares it; nothing this one handed out may be used after this
+ *
+ * parameters: none
+ * returns:    none
+ */
+void GraphFile::close()
+{
+    mapping.reset();
+    base = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * share
+ * purpose: use the mapping another GraphFile has open, so both read the
+ *          same pages of the same file, even if the file has since been
+ *          replaced or removed
+ *
+ * parameters: the GraphFile to share with; if it has nothing open, this
+ *             is closed
+ * returns:    none
+ */
+void GraphFile::share(const GraphFile &other)
+{
+    if (this == &other) return;
+    mapping = other.mapping;
+    base = other.base;
+    size = other.size;
+    header = other.header;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * swap
+ * purpose: trade mappings with another GraphFile; what each handed out
+ *          stays valid, since nothing is unmapped
+ *
+ * parameters: the other GraphFile
+ * returns:    none
+ */
+void GraphFile::swap(GraphFile &other)
+{
+    mapping.swap(other.mapping);
+    std::swap(base, other.base);
+    std::swap(size, other.size);
+    std::swap(header, other.header);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * is_open / vertex_count / song_count / bytes
+ * purpose: report on the mapped file; the counts are 0 when none is open
+ */
+bool GraphFile::is_open() const
+{
+    return base != nullptr;
+}
+
+size_t GraphFile::vertex_count() const
+{
+    return header == nullptr ? 0 : header->vertexCount;
+}
+
+size_t GraphFile::song_count() const
+{
+    return header == nullptr ? 0 : header->songCount;
+}
+
+size_t GraphFile::bytes() const
+{
+    return size;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * adjacency
+ * purpose: find a vertex's compressed adjacency list
+ *
+ * parameters: a vertex ID, which must be less than vertex_count()
+ * returns:    the first byte of the list (its degree)
+ */
+const uint8_t *GraphFile::adjacency(size_t id) const
+{
+    const uint64_t *starts = (const uint64_t *) (base +
+                                                 header->adjacencyStarts);
+    return base + header->adjacency + starts[id];
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * pool
+ * purpose: find the song ID runs the adjacency lists point into
+ *
+ * parameters: none
+ * returns:    the first song ID of the pool
+ */
+const uint32_t *GraphFile::pool() const
+{
+    return (const uint32_t *) (base + header->pool);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * name / title
+ * purpose: read an artist name by vertex ID, or a song title by song ID
+ *
+ * parameters: an ID less than vertex_count() or song_count()
+ * returns:    the string, which stays valid until the file is closed
+ */
+string_view GraphFile::name(size_t id) const
+{
+    return get(header->names, id);
+}
+
+string_view GraphFile::title(size_t song) const
+{
+    return get(header->titles, song);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * find_name / find_title
+ * purpose: look up the ID of an artist name or a song title
+ *
+ * parameters: the name or title
+ * returns:    its ID, or NOT_FOUND
+ */
+size_t GraphFile::find_name(string_view name) const
+{
+    return find(header->names, header->vertexCount, name);
+}
+
+size_t GraphFile::find_title(string_view title) const
+{
+    return find(header->titles, header->songCount, title);
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * layout_strings
+ * purpose: decide where a set of strings and its hash table go
+ *
+ * parameters: the strings, where their section starts, and where to note
+ *             the layout
+ * returns:    where the next section can start
+ *
+ * notes: the table has at least twice as many slots as strings, so probes
+ *        stay short
+ */
+uint64_t GraphFile::layout_strings(const vector<string_view> &list,
+                                   uint64_t at, Strings &where)
+{
+    where.starts = at;
+    at = align8(at + (list.size() + 1) * sizeof(uint64_t));
+    where.text = at;
+    where.textBytes = 0;
+    for (size_t i = 0; i < list.size(); i++) {
+        where.textBytes += list[i].size();
+    }
+    at = align8(at + where.textBytes);
+    where.slots = at;
+    where.slotCount = 2;
+    while (where.slotCount < 2 * list.size()) where.slotCount *= 2;
+    return align8(at + where.slotCount * sizeof(uint32_t));
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * write_strings
+ * purpose: write a set of strings and its hash table where layout_strings
+ *          put them
+ *
+ * parameters: the stream, the strings, their layout, and how many bytes
+ *             have been written so far (updated)
+ * returns:    none
+ */
+void GraphFile::write_strings(ostream &out, const vector<string_view> &list,
+                              const Strings &where, uint64_t &at)
+{
+    pad(out, at, where.starts);
+    uint64_t start = 0;
+    for (size_t i = 0; i <= list.size(); i++) {
+        out.write((const char *) &start, sizeof(start));
+        if (i < list.size()) start += list[i].size();
+    }
+    at += (list.size() + 1) * sizeof(uint64_t);
+
+    pad(out, at, where.text);
+    for (size_t i = 0; i < list.size(); i++) {
+        out.write(list[i].data(), list[i].size());
+    }
+    at += where.textBytes;
+
+    vector<uint32_t> slots(where.slotCount, EMPTY);
+    uint64_t mask = where.slotCount - 1;
+    for (size_t i = 0; i < list.size(); i++) {
+        uint64_t slot = NameHash()(list[i]) & mask;
+        while (slots[slot] != EMPTY) slot = (slot + 1) & mask;
+        slots[slot] = i;
+    }
+    pad(out, at, where.slots);
+    out.write((const char *) slots.data(), slots.size() * sizeof(uint32_t));
+    at += slots.size() * sizeof(uint32_t);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * pad
+ * purpose: write zeros up to where the next section starts
+ */
+void GraphFile::pad(ostream &out, uint64_t &at, uint64_t to)
+{
+    while (at < to) {
+        out.put('\0');
+        at++;
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * fits
+ * purpose: check that a section of 'count' items of 'itemSize' bytes, or a
+ *          set of strings with its table, is aligned and inside the file
+ */
+bool GraphFile::fits(uint64_t at, uint64_t count, size_t itemSize) const
+{
+    return at % 8 == 0 and at <= size and count <= (size - at) / itemSize;
+}
+
+bool GraphFile::fits(const Strings &where, uint64_t count) const
+{
+    return fits(where.starts, count + 1, sizeof(uint64_t)) and
+           fits(where.text, where.textBytes, 1) and
+           fits(where.slots, where.slotCount, sizeof(uint32_t)) and
+           where.slotCount > count and
+           (where.slotCount & (where.slotCount - 1)) == 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get
+ * purpose: read string 'i' of a set of strings
+ */
+string_view GraphFile::get(const Strings &where, size_t i) const
+{
+    const uint64_t *starts = (const uint64_t *) (base + where.starts);
+    return string_view((const char *) base + where.text + starts[i],
+                       starts[i + 1] - starts[i]);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * find
+ * purpose: look a string up in a set's hash table
+ *
+ * parameters: the set, how many strings it has, and the string
+ * returns:    the string's ID, or NOT_FOUND
+ *
+ * notes: probing goes on to the next slot until the string or an empty slot
+ *        turns up; the table is never full, so it always stops
+ */
+size_t GraphFile::find(const Strings &where, uint64_t count,
+                       string_view key) const
+{
+    const uint32_t *slots = (const uint32_t *) (base + where.slots);
+    uint64_t mask = where.slotCount - 1;
+    for (uint64_t slot = NameHash()(key) & mask; slots[slot] != EMPTY;
+         slot = (slot + 1) & mask) {
+        if (slots[slot] < count and get(where, slots[slot]) == key) {
+            return slots[slot];
+        }
+    }
+    return NOT_FOUND;
+}
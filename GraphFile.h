@@ -0,0 +1,142 @@
+/**
+ ** GraphFile.h
+ **
+ ** Purpose:
+ **   A collaboration graph saved as one binary file that is memory-mapped
+ **   instead of loaded, so a graph can be searched on a machine with less
+ **   memory than the graph: the kernel pages in the parts a search touches
+ **   and is free to drop them again.
+ **
+ **   The file holds, each section starting on an 8 byte boundary:
+ **     - a header with the counts and where every section starts
+ **     - the compressed adjacency lists (see CollabGraph::compress), in
+ **       vertex ID order, and where each vertex's list starts
+ **     - the song ID runs of the edges
+ **     - the artist names and the song titles, each as the bytes of every
+ **       string back to back, where each one starts, and an open-addressed
+ **       hash table of IDs for looking them up by name
+ **
+ ** Notes:
+ **   1) a vertex's edges are contiguous and the lists are in ID order, so
+ **      a graph renumbered before it is written (--order bfs or rcm) keeps
+ **      the lists a search reads next to each other on disk
+ **   2) the hash tables use NameHash, whose value depends on the machine's
+ **      byte order, so a file only opens on a machine of the byte order it
+ **      was written on
+ **   3) open() checks that every section fits in the file but not the
+ **      contents of the sections; files are meant to come from write()
+ **   4) a GraphFile cannot be copied, but share() makes it use another's
+ **      mapping: the mapping is counted and unmapped when the last
+ **      GraphFile using it closes, so a copy of a graph reads the very
+ **      file its source does, even if that file was replaced since. Two
+ **      can also swap mappings, so a graph can be moved.
+ **
+ **/
+
+#ifndef __GRAPH_FILE__
+#define __GRAPH_FILE__
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class GraphFile {
+
+public:
+    GraphFile();
+    ~GraphFile();
+
+    GraphFile(const GraphFile &) = delete;
+    GraphFile &operator=(const GraphFile &) = delete;
+
+    static const size_t NOT_FOUND = (size_t) -1;
+
+    /* what write() saves, all pointing into the graph being saved */
+    struct Contents {
+        std::vector<std::string_view> names;     /* by vertex ID */
+        std::vector<std::string_view> titles;    /* by song ID */
+        const uint8_t  *adjacency;
+        size_t          adjacencyBytes;
+        const uint64_t *adjacencyStarts;         /* one per vertex */
+        const uint32_t *pool;
+        size_t          poolCount;
+    };
+
+    static void write(const std::string &path, const Contents &contents);
+    static bool is_graph_file(const std::string &path);
+
+    /* Mutators */
+    void open(const std::string &path);
+    void close();
+    void share(const GraphFile &other);
+    void swap(GraphFile &other);
+
+    /* Accessors */
+    bool             is_open() const;
+    size_t           vertex_count() const;
+    size_t           song_count() const;
+    const uint8_t   *adjacency(size_t id) const;
+    const uint32_t  *pool() const;
+    std::string_view name(size_t id) const;
+    std::string_view title(size_t song) const;
+    size_t           find_name(std::string_view name) const;
+    size_t           find_title(std::string_view title) const;
+    size_t           bytes() const;
+
+private:
+    static const uint64_t MAGIC = 0x3146524753474544ull; /* "DEGSGRF1" */
+    static const uint64_t ENDIAN_MARK = 0x0102030405060708ull;
+    static const uint32_t EMPTY = (uint32_t) -1;
+
+    /* where one set of strings and its hash table are in the file */
+    struct Strings {
+        uint64_t starts;    /* count + 1 offsets into 'text' */
+        uint64_t text;
+        uint64_t textBytes;
+        uint64_t slots;     /* 'slotCount' IDs, EMPTY where unused */
+        uint64_t slotCount; /* a power of two */
+    };
+
+    struct Header {
+        uint64_t magic;
+        uint64_t byteOrder;
+        uint64_t fileBytes;
+        uint64_t vertexCount;
+        uint64_t songCount;
+        uint64_t adjacency;
+        uint64_t adjacencyBytes;
+        uint64_t adjacencyStarts;
+        uint64_t pool;
+        uint64_t poolCount;
+        Strings  names;
+        Strings  titles;
+    };
+
+    static uint64_t layout_strings(const std::vector<std::string_view> &list,
+                                   uint64_t at, Strings &where);
+    static void     write_strings(std::ostream &out,
+                                  const std::vector<std::string_view> &list,
+                                  const Strings &where, uint64_t &at);
+    static void     pad(std::ostream &out, uint64_t &at, uint64_t to);
+    static void     write_sections(std::ostream &out, const Header &header,
+                                   const Contents &contents);
+
+    bool             fits(uint64_t at, uint64_t count, size_t itemSize) const;
+    bool             fits(const Strings &where, uint64_t count) const;
+    std::string_view get(const Strings &where, size_t i) const;
+    size_t           find(const Strings &where, uint64_t count,
+                          std::string_view key) const;
+
+    /* unmaps the file once the last GraphFile sharing it lets go */
+    std::shared_ptr<const uint8_t> mapping;
+
+    const uint8_t *base;    /* the mapping, or nullptr */
+    size_t         size;
+    const Header  *header;
+};
+
+#endif /* __GRAPH_FILE__ */
@@ -0,0 +1,227 @@
+/**
+ ** GraphStats.cpp
+ **
+ ** Purpose:
+ **   Counts, degree spread and components of a CollabGraph.
+ **   See GraphStats.h
+ **
+ **/
+
+#include <algorithm>
+
+#include "GraphStats.h"
+
+using namespace std;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: constructor
+ * @purpose: count everything the accessors report
+ *
+ * @parameters: the graph, which is only read while constructing
+ */
+GraphStats::GraphStats(const CollabGraph &graph)
+{
+    vertexCount = graph.vertex_count();
+    songCount = graph.song_count();
+    edgeCount = sharedCount = 0;
+    minDegree = medianDegree = maxDegree = 0;
+    componentCount = largest = 0;
+
+    //the queue holds every component in turn, in search order; each edge
+    //is in both of its artists' lists, so it is counted from the lower ID
+    vector<uint32_t> degrees(vertexCount);
+    vector<uint32_t> queue;
+    queue.reserve(vertexCount);
+    vector<bool> seen(vertexCount, false);
+    for (size_t start = 0; start < vertexCount; start++) {
+        if (seen[start]) continue;
+        size_t first = queue.size();
+        queue.push_back(start);
+        seen[start] = true;
+        for (size_t head = first; head < queue.size(); head++) {
+            size_t vertex = queue[head];
+            CollabGraph::Neighbors edge = graph.neighbors(vertex);
+            while (edge.next()) {
+                size_t other = edge.neighbor();
+                degrees[vertex]++;
+                if (vertex < other) {
+                    edgeCount++;
+                    sharedCount += edge.strength();
+                }
+                if (not seen[other]) {
+                    seen[other] = true;
+                    queue.push_back(other);
+                }
+            }
+        }
+
+        size_t size = queue.size() - first;
+        size_t bucket = bucket_of(size);
+        if (componentCounts.size() <= bucket) {
+            componentCounts.resize(bucket + 1);
+        }
+        componentCounts[bucket]++;
+        componentCount++;
+        largest = max(largest, size);
+    }
+
+    for (size_t v = 0; v < vertexCount; v++) {
+        size_t bucket = bucket_of(degrees[v]);
+        if (degreeCounts.size() <= bucket) degreeCounts.resize(bucket + 1);
+        degreeCounts[bucket]++;
+    }
+    if (vertexCount > 0) {
+        auto middle = degrees.begin() + vertexCount / 2;
+        nth_element(degrees.begin(), middle, degrees.end());
+        medianDegree = *middle;
+        minDegree = *min_element(degrees.begin(), middle + 1);
+        maxDegree = *max_element(middle, degrees.end());
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * artists / edges / songs / shared_songs
+ * purpose: report the size of the graph
+ *
+ * parameters: none
+ * returns:    the number of artists, of pairs of artists who share a song,
+ *             of distinct song titles, and of songs over all those pairs
+ *             (a song three artists share counts for three pairs)
+ */
+size_t GraphStats::artists() const
+{
+    return vertexCount;
+}
+
+size_t GraphStats::edges() const
+{
+    return edgeCount;
+}
+
+size_t GraphStats::songs() const
+{
+    return songCount;
+}
+
+size_t GraphStats::shared_songs() const
+{
+    return sharedCount;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * min_degree / median_degree / mean_degree / max_degree / degree_buckets
+ * purpose: report how many collaborators the artists have
+ *
+ * parameters: none
+ * returns:    the fewest, the median (the upper one of an even count), the
+ *             mean and the most, all 0 for an empty graph; or the number
+ *             of artists in each degree bucket, smallest degrees first,
+ *             empty buckets included up to the largest degree
+ */
+size_t GraphStats::min_degree() const
+{
+    return minDegree;
+}
+
+size_t GraphStats::median_degree() const
+{
+    return medianDegree;
+}
+
+double GraphStats::mean_degree() const
+{
+    return vertexCount == 0 ? 0 : 2.0 * edgeCount / vertexCount;
+}
+
+size_t GraphStats::max_degree() const
+{
+    return maxDegree;
+}
+
+vector<GraphStats::Bucket> GraphStats::degree_buckets() const
+{
+    return list(degreeCounts);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * components / largest_component / component_buckets
+ * purpose: report how the graph falls apart into connected components
+ *
+ * parameters: none
+ * returns:    how many components there are, how many artists the biggest
+ *             has, or the number of components in each size bucket (the
+ *             0 bucket is always empty)
+ */
+size_t GraphStats::components() const
+{
+    return componentCount;
+}
+
+size_t GraphStats::largest_component() const
+{
+    return largest;
+}
+
+vector<GraphStats::Bucket> GraphStats::component_buckets() const
+{
+    return list(componentCounts);
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * bucket_of
+ * purpose: find the bucket a degree or size is counted in
+ *
+ * parameters: the degree or size
+ * returns:    0 for 0, and otherwise one more than its highest set bit, so
+ *             bucket b holds 2^(b-1) to 2^b - 1
+ */
+size_t GraphStats::bucket_of(size_t value)
+{
+    size_t bucket = 0;
+    while (value > 0) {
+        bucket++;
+        value >>= 1;
+    }
+    return bucket;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * list
+ * purpose: turn counts per bucket into buckets with their ranges
+ *
+ * parameters: the count of each bucket, indexed as bucket_of numbers them
+ * returns:    one Bucket per count
+ */
+vector<GraphStats::Bucket> GraphStats::list(const vector<size_t> &counts)
+{
+    vector<Bucket> buckets;
+    for (size_t b = 0; b < counts.size(); b++) {
+        size_t low = b == 0 ? 0 : (size_t) 1 << (b - 1);
+        size_t high = b == 0 ? 0 : ((size_t) 1 << b) - 1;
+        buckets.push_back(Bucket{low, high, counts[b]});
+    }
+    return buckets;
+}
@@ -0,0 +1,74 @@
+/**
+ ** GraphStats.h
+ **
+ ** Purpose:
+ **   The shape of a CollabGraph at a glance: how many artists, edges and
+ **   songs it has, how the artists' degrees are spread out and how the
+ **   graph falls apart into connected components. Degrees and component
+ **   sizes are counted in buckets that double in width (1, 2-3, 4-7,
+ **   8-15, ...), with 0 on its own, so a graph of any size is described in
+ **   a few dozen lines.
+ **
+ ** Notes:
+ **   1) everything is counted in one pass over the vertices and one
+ **      breadth-first pass over the edges, walking each adjacency list in
+ **      place with the Neighbors iterator; nothing is copied
+ **   2) memory is about 9 bytes per artist while counting, and only the
+ **      buckets and a few totals are kept
+ **   3) an artist with no collaborators is a component of its own
+ **
+ **/
+
+#ifndef __GRAPH_STATS__
+#define __GRAPH_STATS__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CollabGraph.h"
+
+class GraphStats {
+
+public:
+    /* 'count' degrees (or components) of 'low' to 'high', inclusive */
+    struct Bucket {
+        size_t low;
+        size_t high;
+        size_t count;
+    };
+
+    GraphStats(const CollabGraph &graph);
+
+    /* Accessors */
+    size_t              artists() const;
+    size_t              edges() const;
+    size_t              songs() const;
+    size_t              shared_songs() const;
+    size_t              min_degree() const;
+    size_t              median_degree() const;
+    double              mean_degree() const;
+    size_t              max_degree() const;
+    std::vector<Bucket> degree_buckets() const;
+    size_t              components() const;
+    size_t              largest_component() const;
+    std::vector<Bucket> component_buckets() const;
+
+private:
+    static size_t              bucket_of(size_t value);
+    static std::vector<Bucket> list(const std::vector<size_t> &counts);
+
+    size_t vertexCount;
+    size_t edgeCount;
+    size_t songCount;
+    size_t sharedCount;     /* songs over all edges, each edge once */
+    size_t minDegree;
+    size_t medianDegree;
+    size_t maxDegree;
+    size_t componentCount;
+    size_t largest;
+    std::vector<size_t> degreeCounts;       /* artists per degree bucket */
+    std::vector<size_t> componentCounts;    /* components per size bucket */
+};
+
+#endif /* __GRAPH_STATS__ */
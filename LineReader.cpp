@@ -0,0 +1,146 @@
+/**
+ ** LineReader.cpp
+ **
+ ** Purpose:
+ **   Block-buffered line reading for the loader.
+ **   See LineReader.h
+ **
+ **/
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "LineReader.h"
+
+using namespace std;
+
+const size_t LineReader::BUFFER_SIZE;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: constructor
+ * @purpose: open a file for reading; check fail() before reading
+ *
+ * @parameters: the name of the file
+ */
+LineReader::LineReader(const string &filename)
+    : file(filename, ios::in | ios::binary)
+{
+    start = 0;
+    filled = 0;
+    atEnd = false;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * fail
+ * purpose: report whether the file could not be opened
+ *
+ * parameters: none
+ * returns: true iff the file could not be opened
+ */
+bool LineReader::fail() const
+{
+    return not file.is_open();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * next
+ * purpose: read the next line
+ *
+ * parameters: where to put the line
+ * returns: false once there are no more lines, true otherwise
+ */
+bool LineReader::next(string_view &line)
+{
+    while (true) {
+        const char *begin = buffer.data() + start;
+        const char *end = buffer.data() + filled;
+        const char *newline = begin == end ? end : find_newline(begin, end);
+
+        if (newline != end) {
+            line = string_view(begin, newline - begin);
+            start += line.size() + 1;
+            return true;
+        }
+        if (not refill()) { //the file ended in the middle of a line
+            if (start == filled) return false;
+            line = string_view(buffer.data() + start, filled - start);
+            start = filled;
+            return true;
+        }
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * find_newline
+ * purpose: find the first '\n' in [at, end)
+ *
+ * parameters: the bytes to search
+ * returns: a pointer to the '\n', or 'end' if there is none
+ *
+ * notes: with SSE2 it compares sixteen bytes per instruction and finds the
+ *        first match from the comparison's bit mask
+ */
+const char *LineReader::find_newline(const char *at, const char *end)
+{
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - at >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask != 0) return at + __builtin_ctz(mask);
+        at += 16;
+    }
+#endif
+    const void *found = memchr(at, '\n', end - at);
+    return found == nullptr ? end : static_cast<const char *>(found);
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * refill
+ * purpose: move the unfinished line to the front of the buffer and read
+ *          the next block of the file after it
+ *
+ * returns: false if the file had nothing more to read
+ */
+bool LineReader::refill()
+{
+    if (atEnd or not file.is_open()) return false;
+
+    size_t kept = filled - start;
+    if (kept > 0) memmove(buffer.data(), buffer.data() + start, kept);
+    start = 0;
+    filled = kept;
+
+    if (buffer.size() < BUFFER_SIZE) buffer.resize(BUFFER_SIZE);
+    if (filled == buffer.size()) buffer.resize(buffer.size() * 2);
+
+    file.read(buffer.data() + filled, buffer.size() - filled);
+    size_t got = file.gcount();
+    filled += got;
+    if (got == 0 or file.eof()) atEnd = true;
+    return got > 0;
+}
@@ -0,0 +1,51 @@
+/**
+ ** LineReader.h
+ **
+ ** Purpose:
+ **   Read a text file line by line for the loader, without the per-line
+ **   costs of std::getline. The file is read in large blocks and each line
+ **   is handed out as a string_view into the block, found by scanning for
+ **   the newline sixteen bytes at a time with SSE2 where the compiler
+ **   targets it (and memchr elsewhere).
+ **
+ ** Notes:
+ **   1) a line is everything up to the next '\n', which is not included,
+ **      exactly like std::getline; a last line with no '\n' still counts,
+ **      but an empty file or a final '\n' adds no empty line
+ **   2) a line is only valid until the next call to next()
+ **   3) a line longer than the buffer makes the buffer grow to fit it
+ **
+ **/
+
+#ifndef __LINE_READER__
+#define __LINE_READER__
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class LineReader {
+
+public:
+    LineReader(const std::string &filename);
+
+    bool fail() const;
+    bool next(std::string_view &line);
+
+    static const char *find_newline(const char *at, const char *end);
+
+private:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    bool refill();
+
+    std::ifstream     file;
+    std::vector<char> buffer;
+    size_t            start;    /* first byte not yet handed out */
+    size_t            filled;   /* bytes of 'buffer' holding file data */
+    bool              atEnd;    /* the whole file has been read */
+};
+
+#endif /* __LINE_READER__ */
@@ -0,0 +1,307 @@
+/**
+ ** NameFold.cpp
+ **
+ ** Purpose:
+ **   Normalizing names before they are interned. See NameFold.h
+ **
+ **/
+
+#include <algorithm>
+
+#include "NameFold.h"
+
+using namespace std;
+
+/* an ASCII letter and the combining accent after it that make one of the
+ * precomposed letters U+00C0 to U+017F, sorted by letter and accent */
+static const struct Composition {
+    char     base;
+    uint16_t mark;
+    uint16_t composed;
+} COMPOSITIONS[] = {
+    {'A', 0x300, 0x0C0}, {'A', 0x301, 0x0C1}, {'A', 0x302, 0x0C2},
+    {'A', 0x303, 0x0C3}, {'A', 0x304, 0x100}, {'A', 0x306, 0x102},
+    {'A', 0x308, 0x0C4}, {'A', 0x30A, 0x0C5}, {'A', 0x328, 0x104},
+    {'C', 0x301, 0x106}, {'C', 0x302, 0x108}, {'C', 0x307, 0x10A},
+    {'C', 0x30C, 0x10C}, {'C', 0x327, 0x0C7}, {'D', 0x30C, 0x10E},
+    {'E', 0x300, 0x0C8}, {'E', 0x301, 0x0C9}, {'E', 0x302, 0x0CA},
+    {'E', 0x304, 0x112}, {'E', 0x306, 0x114}, {'E', 0x307, 0x116},
+    {'E', 0x308, 0x0CB}, {'E', 0x30C, 0x11A}, {'E', 0x328, 0x118},
+    {'G', 0x302, 0x11C}, {'G', 0x306, 0x11E}, {'G', 0x307, 0x120},
+    {'G', 0x327, 0x122}, {'H', 0x302, 0x124}, {'I', 0x300, 0x0CC},
+    {'I', 0x301, 0x0CD}, {'I', 0x302, 0x0CE}, {'I', 0x303, 0x128},
+    {'I', 0x304, 0x12A}, {'I', 0x306, 0x12C}, {'I', 0x307, 0x130},
+    {'I', 0x308, 0x0CF}, {'I', 0x328, 0x12E}, {'J', 0x302, 0x134},
+    {'K', 0x327, 0x136}, {'L', 0x301, 0x139}, {'L', 0x30C, 0x13D},
+    {'L', 0x327, 0x13B}, {'N', 0x301, 0x143}, {'N', 0x303, 0x0D1},
+    {'N', 0x30C, 0x147}, {'N', 0x327, 0x145}, {'O', 0x300, 0x0D2},
+    {'O', 0x301, 0x0D3}, {'O', 0x302, 0x0D4}, {'O', 0x303, 0x0D5},
+    {'O', 0x304, 0x14C}, {'O', 0x306, 0x14E}, {'O', 0x308, 0x0D6},
+    {'O', 0x30B, 0x150}, {'R', 0x301, 0x154}, {'R', 0x30C, 0x158},
+    {'R', 0x327, 0x156}, {'S', 0x301, 0x15A}, {'S', 0x302, 0x15C},
+    {'S', 0x30C, 0x160}, {'S', 0x327, 0x15E}, {'T', 0x30C, 0x164},
+    {'T', 0x327, 0x162}, {'U', 0x300, 0x0D9}, {'U', 0x301, 0x0DA},
+    {'U', 0x302, 0x0DB}, {'U', 0x303, 0x168}, {'U', 0x304, 0x16A},
+    {'U', 0x306, 0x16C}, {'U', 0x308, 0x0DC}, {'U', 0x30A, 0x16E},
+    {'U', 0x30B, 0x170}, {'U', 0x328, 0x172}, {'W', 0x302, 0x174},
+    {'Y', 0x301, 0x0DD}, {'Y', 0x302, 0x176}, {'Y', 0x308, 0x178},
+    {'Z', 0x301, 0x179}, {'Z', 0x307, 0x17B}, {'Z', 0x30C, 0x17D},
+    {'a', 0x300, 0x0E0}, {'a', 0x301, 0x0E1}, {'a', 0x302, 0x0E2},
+    {'a', 0x303, 0x0E3}, {'a', 0x304, 0x101}, {'a', 0x306, 0x103},
+    {'a', 0x308, 0x0E4}, {'a', 0x30A, 0x0E5}, {'a', 0x328, 0x105},
+    {'c', 0x301, 0x107}, {'c', 0x302, 0x109}, {'c', 0x307, 0x10B},
+    {'c', 0x30C, 0x10D}, {'c', 0x327, 0x0E7}, {'d', 0x30C, 0x10F},
+    {'e', 0x300, 0x0E8}, {'e', 0x301, 0x0E9}, {'e', 0x302, 0x0EA},
+    {'e', 0x304, 0x113}, {'e', 0x306, 0x115}, {'e', 0x307, 0x117},
+    {'e', 0x308, 0x0EB}, {'e', 0x30C, 0x11B}, {'e', 0x328, 0x119},
+    {'g', 0x302, 0x11D}, {'g', 0x306, 0x11F}, {'g', 0x307, 0x121},
+    {'g', 0x327, 0x123}, {'h', 0x302, 0x125}, {'i', 0x300, 0x0EC},
+    {'i', 0x301, 0x0ED}, {'i', 0x302, 0x0EE}, {'i', 0x303, 0x129},
+    {'i', 0x304, 0x12B}, {'i', 0x306, 0x12D}, {'i', 0x308, 0x0EF},
+    {'i', 0x328, 0x12F}, {'j', 0x302, 0x135}, {'k', 0x327, 0x137},
+    {'l', 0x301, 0x13A}, {'l', 0x30C, 0x13E}, {'l', 0x327, 0x13C},
+    {'n', 0x301, 0x144}, {'n', 0x303, 0x0F1}, {'n', 0x30C, 0x148},
+    {'n', 0x327, 0x146}, {'o', 0x300, 0x0F2}, {'o', 0x301, 0x0F3},
+    {'o', 0x302, 0x0F4}, {'o', 0x303, 0x0F5}, {'o', 0x304, 0x14D},
+    {'o', 0x306, 0x14F}, {'o', 0x308, 0x0F6}, {'o', 0x30B, 0x151},
+    {'r', 0x301, 0x155}, {'r', 0x30C, 0x159}, {'r', 0x327, 0x157},
+    {'s', 0x301, 0x15B}, {'s', 0x302, 0x15D}, {'s', 0x30C, 0x161},
+    {'s', 0x327, 0x15F}, {'t', 0x30C, 0x165}, {'t', 0x327, 0x163},
+    {'u', 0x300, 0x0F9}, {'u', 0x301, 0x0FA}, {'u', 0x302, 0x0FB},
+    {'u', 0x303, 0x169}, {'u', 0x304, 0x16B}, {'u', 0x306, 0x16D},
+    {'u', 0x308, 0x0FC}, {'u', 0x30A, 0x16F}, {'u', 0x30B, 0x171},
+    {'u', 0x328, 0x173}, {'w', 0x302, 0x175}, {'y', 0x301, 0x0FD},
+    {'y', 0x302, 0x177}, {'y', 0x308, 0x0FF}, {'z', 0x301, 0x17A},
+    {'z', 0x307, 0x17C}, {'z', 0x30C, 0x17E}
+};
+
+/* same: the bytes a name may hold and still be its own normal form (ASCII
+ * but the capitals and '`'); lower: what each ASCII byte folds to */
+static const struct Tables {
+    bool same[256];
+    char lower[128];
+    Tables()
+    {
+        for (int c = 0; c < 256; c++) same[c] = c < 0x80;
+        for (int c = 0; c < 128; c++) lower[c] = c;
+        for (int c = 'A'; c <= 'Z'; c++) {
+            same[c] = false;
+            lower[c] = c - 'A' + 'a';
+        }
+        same['`'] = false;
+        lower['`'] = '\'';
+    }
+} ascii;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * fold
+ * purpose: the normal form of a name
+ *
+ * parameters: 1) the name
+ *             2) a string to build the normal form in, if it differs
+ * returns:    the normal form: 'name' itself when it is already normal,
+ *             and otherwise a view of 'scratch'
+ */
+string_view NameFold::fold(string_view name, string &scratch)
+{
+    size_t i = 0;
+    while (i < name.size() and ascii.same[(unsigned char) name[i]]) i++;
+    if (i == name.size()) return name;
+    if (i > 0 and ((unsigned char) name[i] & 0xFE) == 0xCC) {
+        i--; //an accent to compose with the letter before it
+    }
+
+    scratch.assign(name.data(), i);
+    while (i < name.size()) {
+        unsigned char c = name[i];
+        uint32_t code = c;
+        size_t length = 1;
+        if (c >= 0x80 and (length = decode(name, i, code)) == 0) {
+            scratch += name[i++]; //not UTF-8, kept as it is
+            continue;
+        }
+        i += length;
+
+        //combining accents (U+0300 to U+036F) all start with 0xCC or 0xCD
+        if (c < 0x80 and (i == name.size() or
+                          ((unsigned char) name[i] & 0xFE) != 0xCC)) {
+            scratch += ascii.lower[c];
+            continue;
+        }
+        uint32_t mark, composed;
+        while ((length = decode(name, i, mark)) > 0 and
+               (composed = compose(code, mark)) != 0) {
+            code = composed;
+            i += length;
+        }
+        put_folded(code, scratch);
+    }
+    return scratch;
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * decode
+ * purpose: read one UTF-8 character
+ *
+ * parameters: the text, where the character starts and where to put it
+ * returns:    how many bytes it takes, or 0 if there is no character there
+ *             or its bytes are not valid UTF-8 (including overlong forms,
+ *             surrogates and values above U+10FFFF)
+ */
+size_t NameFold::decode(string_view text, size_t at, uint32_t &code)
+{
+    if (at >= text.size()) return 0;
+    unsigned char c = text[at];
+    if (c < 0x80) {
+        code = c;
+        return 1;
+    }
+    size_t length = c >= 0xF8 ? 0 : c >= 0xF0 ? 4 : c >= 0xE0 ? 3
+                  : c >= 0xC0 ? 2 : 0;
+    if (length == 0 or at + length > text.size()) return 0;
+    code = c & (0x7F >> length);
+    for (size_t j = 1; j < length; j++) {
+        unsigned char next = text[at + j];
+        if ((next & 0xC0) != 0x80) return 0;
+        code = code << 6 | (next & 0x3F);
+    }
+    /* overlong forms, surrogates and values past U+10FFFF are not UTF-8;
+     * decoding them would fold stray bytes into real letters */
+    static const uint32_t SMALLEST[] = {0, 0, 0x80, 0x800, 0x10000};
+    if (code < SMALLEST[length] or (code >= 0xD800 and code <= 0xDFFF) or
+        code > 0x10FFFF) {
+        return 0;
+    }
+    return length;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * compose
+ * purpose: the precomposed letter of a letter and a combining accent
+ *
+ * parameters: the letter and the accent
+ * returns:    the precomposed letter, or 0 if there is none in the table
+ */
+uint32_t NameFold::compose(uint32_t base, uint32_t mark)
+{
+    if (base >= 0x80 or mark < 0x300 or mark >= 0x370) return 0;
+    const Composition *end = COMPOSITIONS + size(COMPOSITIONS);
+    const Composition *at = std::lower_bound(COMPOSITIONS, end, base,
+        [](const Composition &entry, uint32_t letter) {
+            return (uint32_t) entry.base < letter;
+        });
+    for (; at != end and (uint32_t) at->base == base; at++) {
+        if (at->mark == mark) return at->composed;
+    }
+    return 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * put_folded
+ * purpose: append the case folded form of a character, with quotes,
+ *          dashes and spaces made ASCII
+ *
+ * parameters: the character and the string to append it to
+ * returns:    none
+ */
+void NameFold::put_folded(uint32_t code, string &out)
+{
+    if (code < 0x80) {
+        out += ascii.lower[code];
+    } else if (code >= 0xC0 and code < 0x180) { //Latin-1 and Extended-A
+        if (code == 0xDF) {
+            out += "ss";
+        } else if (code == 0x130) { //capital I with dot: i and the dot
+            out += 'i';
+            put(0x307, out);
+        } else if (code == 0x149) { //n after an apostrophe
+            out += "'n";
+        } else if (code == 0x178) {
+            put(0xFF, out);
+        } else if (code == 0x17F) { //long s
+            out += 's';
+        } else if ((code < 0xDF and code != 0xD7) or
+                   (code >= 0x100 and code < 0x138 and code % 2 == 0) or
+                   (code >= 0x139 and code < 0x149 and code % 2 == 1) or
+                   (code >= 0x14A and code < 0x178 and code % 2 == 0) or
+                   (code >= 0x179 and code < 0x17F and code % 2 == 1)) {
+            put(code < 0xDF ? code + 0x20 : code + 1, out);
+        } else {
+            put(code, out);
+        }
+    } else if (code >= 0x386 and code < 0x3D0) { //Greek
+        if (code == 0x386) code = 0x3AC;
+        else if (code >= 0x388 and code <= 0x38A) code += 0x25;
+        else if (code == 0x38C) code = 0x3CC;
+        else if (code == 0x38E or code == 0x38F) code += 0x3F;
+        else if (code >= 0x391 and code <= 0x3AB and code != 0x3A2) {
+            code += 0x20;
+        } else if (code == 0x3C2) code = 0x3C3; //final sigma
+        put(code, out);
+    } else if (code >= 0x400 and code < 0x430) { //Cyrillic
+        put(code < 0x410 ? code + 0x50 : code + 0x20, out);
+    } else if (code == 0xB5) { //micro sign, folded like Greek mu
+        put(0x3BC, out);
+    } else if (code == 0x2018 or code == 0x2019 or code == 0x201A or
+               code == 0x201B or code == 0x2032 or code == 0x2035 or
+               code == 0x2BC or code == 0xB4) {
+        out += '\'';
+    } else if ((code >= 0x201C and code <= 0x201F) or code == 0x2033 or
+               code == 0x2036) {
+        out += '"';
+    } else if ((code >= 0x2010 and code <= 0x2015) or code == 0x2212) {
+        out += '-';
+    } else if (code == 0xA0 or (code >= 0x2000 and code <= 0x200A) or
+               code == 0x202F or code == 0x205F or code == 0x3000) {
+        out += ' ';
+    } else {
+        put(code, out);
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * put
+ * purpose: append one character as UTF-8
+ *
+ * parameters: the character and the string to append it to
+ * returns:    none
+ */
+void NameFold::put(uint32_t code, string &out)
+{
+    if (code < 0x80) {
+        out += (char) code;
+    } else if (code < 0x800) {
+        out += (char) (0xC0 | code >> 6);
+        out += (char) (0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += (char) (0xE0 | code >> 12);
+        out += (char) (0x80 | (code >> 6 & 0x3F));
+        out += (char) (0x80 | (code & 0x3F));
+    } else {
+        out += (char) (0xF0 | code >> 18);
+        out += (char) (0x80 | (code >> 12 & 0x3F));
+        out += (char) (0x80 | (code >> 6 & 0x3F));
+        out += (char) (0x80 | (code & 0x3F));
+    }
+}
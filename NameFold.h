@@ -0,0 +1,50 @@
+/**
+ ** NameFold.h
+ **
+ ** Purpose:
+ **   The normalized form the graph interns names under when asked to, so
+ **   that two spellings of one artist or song that differ only in how
+ **   they were typed are the same vertex or the same song:
+ **     - NFC: a Latin letter followed by a combining accent becomes the
+ **       precomposed letter ("e" + U+0301 is "é")
+ **     - case folding: Latin, Greek and Cyrillic capitals become small
+ **       letters ("ß" becomes "ss" and final sigma "σ", as in full case
+ **       folding)
+ **     - quotes, dashes and spaces: curly and typewriter apostrophes
+ **       become "'", curly double quotes '"', the dashes, hyphens and the
+ **       minus sign "-", and the other widths of space " "
+ **   Unlike NameIndex::key, the accents, punctuation and spacing are kept,
+ **   so names that really are different stay different.
+ **
+ ** Notes:
+ **   1) most names are plain lower case ASCII, so a name is first scanned
+ **      with a table of the bytes that might change; if none does, the
+ **      name itself is returned and nothing is copied
+ **   2) other ASCII is folded through a second table, byte by byte; only
+ **      the rest is decoded as UTF-8
+ **   3) characters outside the ranges above, and bytes that are not valid
+ **      UTF-8, are kept as they are
+ **
+ **/
+
+#ifndef __NAME_FOLD__
+#define __NAME_FOLD__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+class NameFold {
+
+public:
+    static std::string_view fold(std::string_view name, std::string &scratch);
+
+private:
+    static size_t   decode(std::string_view text, size_t at, uint32_t &code);
+    static uint32_t compose(uint32_t base, uint32_t mark);
+    static void     put_folded(uint32_t code, std::string &out);
+    static void     put(uint32_t code, std::string &out);
+};
+
+#endif /* __NAME_FOLD__ */
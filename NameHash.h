@@ -0,0 +1,57 @@
+/**
+ ** NameHash.h
+ **
+ ** Purpose:
+ **   The hash the graph's name maps use for artist names and song titles.
+ **   It reads a name eight bytes at a time and mixes each word with a
+ **   multiply and a shift, instead of feeding the hash one byte at a time,
+ **   so the short names the data file is full of take a couple of multiplies
+ **   each. Names are compared with memcmp (by std::string_view) as before.
+ **
+ ** Notes:
+ **   1) only the hash is defined here; it is in the header so the map
+ **      lookups that call it can inline it
+ **   2) the value depends on the machine's byte order. Graph files keep
+ **      tables built with it, so they record the byte order they were
+ **      written with (see GraphFile.h)
+ **
+ **/
+
+#ifndef __NAME_HASH__
+#define __NAME_HASH__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+struct NameHash {
+    size_t operator()(std::string_view name) const
+    {
+        const uint64_t MUL = 0x9E3779B97F4A7C15ull;
+        const char *at = name.data();
+        size_t left = name.size();
+        uint64_t hash = left * MUL;
+
+        while (left >= 8) {
+            uint64_t word;
+            memcpy(&word, at, 8);
+            hash = (hash ^ word) * MUL;
+            hash ^= hash >> 32;
+            at += 8;
+            left -= 8;
+        }
+        if (left > 0) { //the last 1 to 7 bytes, zero padded
+            uint64_t word = 0;
+            memcpy(&word, at, left);
+            hash = (hash ^ word) * MUL;
+            hash ^= hash >> 32;
+        }
+
+        hash ^= hash >> 29;
+        hash *= 0xBF58476D1CE4E5B9ull;
+        return hash ^ (hash >> 32);
+    }
+};
+
+#endif /* __NAME_HASH__ */
@@ -0,0 +1,474 @@
+/**
+ ** NameIndex.cpp
+ **
+ ** Purpose:
+ **   Forgiving lookup and suggestions of artist names. See NameIndex.h
+ **
+ **/
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+#include "NameIndex.h"
+
+using namespace std;
+
+const size_t NameIndex::SCAN;
+const size_t NameIndex::VERIFY;
+
+/* what U+00C0 to U+017F fold to: Latin letters lose their accents, and
+ * the two symbols among them (the multiplication and division signs) are
+ * separators */
+static const char *const LATIN[] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i",
+    "i", "i", "d", "n", "o", "o", "o", "o", "o", " ", "o", "u", "u", "u",
+    "u", "y", "th", "ss", "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e",
+    "e", "e", "i", "i", "i", "i", "d", "n", "o", "o", "o", "o", "o", " ",
+    "o", "u", "u", "u", "u", "y", "th", "y", "a", "a", "a", "a", "a", "a",
+    "c", "c", "c", "c", "c", "c", "c", "c", "d", "d", "d", "d", "e", "e",
+    "e", "e", "e", "e", "e", "e", "e", "e", "g", "g", "g", "g", "g", "g",
+    "g", "g", "h", "h", "h", "h", "i", "i", "i", "i", "i", "i", "i", "i",
+    "i", "i", "ij", "ij", "j", "j", "k", "k", "k", "l", "l", "l", "l", "l",
+    "l", "l", "l", "l", "l", "n", "n", "n", "n", "n", "n", "n", "n", "n",
+    "o", "o", "o", "o", "o", "o", "oe", "oe", "r", "r", "r", "r", "r", "r",
+    "s", "s", "s", "s", "s", "s", "s", "s", "t", "t", "t", "t", "t", "t",
+    "u", "u", "u", "u", "u", "u", "u", "u", "u", "u", "u", "u", "w", "w",
+    "y", "y", "y", "z", "z", "z", "z", "z", "z", "s"
+};
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: constructor
+ * @purpose: make an empty index, which finds nothing until it is built
+ */
+NameIndex::NameIndex()
+{
+    graph = nullptr;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * build
+ * purpose: index every artist of a graph, replacing what was indexed
+ *
+ * parameters: the graph, which must outlive the index (or its next build)
+ * returns:    none
+ *
+ * notes: the keys are folded into one buffer first and sorted as views of
+ *        it, so no string is made per artist
+ */
+void NameIndex::build(const CollabGraph &g)
+{
+    graph = &g;
+    size_t count = g.vertex_count();
+
+    string folded;
+    vector<uint64_t> start;
+    for (size_t v = 0; v < count; v++) {
+        start.push_back(folded.size());
+        folded += key(g.name_view(v));
+    }
+    start.push_back(folded.size());
+
+    auto view = [&](size_t v) {
+        return string_view(folded).substr(start[v], start[v + 1] - start[v]);
+    };
+    vector<uint32_t> order(count);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+        int diff = view(x).compare(view(y));
+        return diff < 0 or (diff == 0 and x < y);
+    });
+
+    keys.clear();
+    keys.reserve(folded.size());
+    keyStart.clear();
+    keyVertex.assign(order.begin(), order.end());
+    for (size_t i = 0; i < count; i++) {
+        keyStart.push_back(keys.size());
+        keys += view(order[i]);
+    }
+    keyStart.push_back(keys.size());
+
+    //every (trigram, key) pair once, sorted, then grouped by trigram
+    vector<uint64_t> pairs;
+    vector<uint32_t> mine;
+    for (size_t i = 0; i < count; i++) {
+        mine.clear();
+        add_grams(key_at(i), mine);
+        for (size_t j = 0; j < mine.size(); j++) {
+            pairs.push_back((uint64_t) mine[j] << 32 | i);
+        }
+    }
+    sort(pairs.begin(), pairs.end());
+    pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+
+    grams.clear();
+    gramStart.clear();
+    gramKeys.resize(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        uint32_t gram = pairs[i] >> 32;
+        if (grams.empty() or grams.back() != gram) {
+            grams.push_back(gram);
+            gramStart.push_back(i);
+        }
+        gramKeys[i] = (uint32_t) pairs[i];
+    }
+    gramStart.push_back(pairs.size());
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * rebind
+ * purpose: point the index at the graph it was built from, after that graph
+ *          was moved to another CollabGraph object
+ *
+ * parameters: the graph now holding what the index was built from
+ * returns:    none
+ */
+void NameIndex::rebind(const CollabGraph &g)
+{
+    graph = &g;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * find
+ * purpose: look up an artist by a name that may differ from theirs in case,
+ *          accents, apostrophes, spacing or punctuation
+ *
+ * parameters: the name
+ * returns:    the vertex ID of the artist with the same key, the most
+ *             collaborators and the lowest ID, or NO_VERTEX if none has it
+ */
+size_t NameIndex::find(string_view name) const
+{
+    string wanted = key(name);
+    if (wanted.empty()) return CollabGraph::NO_VERTEX;
+
+    size_t found = CollabGraph::NO_VERTEX;
+    for (size_t i = lower_bound(wanted);
+         i < keyVertex.size() and key_at(i) == wanted; i++) {
+        if (found == CollabGraph::NO_VERTEX or better(i, found)) found = i;
+    }
+    return found == CollabGraph::NO_VERTEX ? found : keyVertex[found];
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * suggest
+ * purpose: autocomplete and correct an artist name
+ *
+ * parameters: what was typed so far, and how many artists to suggest
+ * returns:    up to 'count' vertex IDs, best first (see NameIndex.h)
+ */
+vector<size_t> NameIndex::suggest(string_view text, size_t count) const
+{
+    vector<size_t> picked;
+    string wanted = key(text);
+    if (wanted.empty() or count == 0) return picked;
+
+    //keys that start with the text: the exact ones, then by degree
+    vector<size_t> starts;
+    for (size_t i = lower_bound(wanted);
+         i < keyVertex.size() and
+         key_at(i).substr(0, wanted.size()) == wanted; i++) {
+        starts.push_back(i);
+    }
+    auto ranked = [&](size_t x, size_t y) {
+        bool xExact = key_at(x).size() == wanted.size();
+        bool yExact = key_at(y).size() == wanted.size();
+        if (xExact != yExact) return xExact;
+        return better(x, y);
+    };
+    size_t keep = min(count, starts.size());
+    partial_sort(starts.begin(), starts.begin() + keep, starts.end(), ranked);
+    for (size_t i = 0; i < keep; i++) picked.push_back(starts[i]);
+    if (picked.size() < count) add_close(wanted, count, picked);
+
+    for (size_t i = 0; i < picked.size(); i++) {
+        picked[i] = keyVertex[picked[i]];
+    }
+    return picked;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * bytes
+ * purpose: report the memory the index holds, for capacity planning
+ *
+ * parameters: none
+ * returns:    the bytes of its keys, key tables and trigram lists
+ */
+size_t NameIndex::bytes() const
+{
+    return keys.capacity() + keyStart.capacity() * sizeof(uint64_t) +
+           (keyVertex.capacity() + grams.capacity() + gramStart.capacity() +
+            gramKeys.capacity()) * sizeof(uint32_t);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * key
+ * purpose: fold a name to the key it is indexed and looked up by
+ *
+ * parameters: a name in UTF-8
+ * returns:    its key (see NameIndex.h); empty if it has no letters or
+ *             digits
+ *
+ * notes: ASCII, by far the most common, takes one table lookup a byte.
+ *        Characters outside Latin-1 and Latin Extended-A that are not
+ *        punctuation are kept as they are; bytes that are not valid UTF-8
+ *        are kept too.
+ */
+string NameIndex::key(string_view name)
+{
+    //ASCII: 0 is a separator, 1 is dropped, anything else is kept as that
+    static const struct Table {
+        char fold[128];
+        Table()
+        {
+            for (int c = 0; c < 128; c++) fold[c] = 0;
+            for (int c = '0'; c <= '9'; c++) fold[c] = c;
+            for (int c = 'a'; c <= 'z'; c++) fold[c] = c;
+            for (int c = 'A'; c <= 'Z'; c++) fold[c] = c - 'A' + 'a';
+            fold['\''] = 1;
+            fold['`'] = 1;
+        }
+    } ascii;
+
+    string folded;
+    folded.reserve(name.size());
+    bool gap = false; //a separator since the last character kept
+    auto put = [&](string_view text) {
+        if (gap and not folded.empty()) folded += ' ';
+        gap = false;
+        folded += text;
+    };
+
+    size_t i = 0;
+    while (i < name.size()) {
+        unsigned char c = name[i];
+        if (c < 0x80) {
+            char fold = ascii.fold[c];
+            if (fold == 0) gap = true;
+            else if (fold != 1) put(string_view(&fold, 1));
+            i++;
+            continue;
+        }
+
+        //decode one UTF-8 character; a bad sequence is kept byte by byte
+        size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        uint32_t code = length == 1 ? c : c & (0x7F >> length);
+        bool valid = length > 1 and i + length <= name.size();
+        for (size_t j = 1; valid and j < length; j++) {
+            unsigned char next = name[i + j];
+            valid = (next & 0xC0) == 0x80;
+            code = code << 6 | (next & 0x3F);
+        }
+        if (not valid) {
+            put(name.substr(i, 1));
+            i++;
+            continue;
+        }
+
+        if (code >= 0xC0 and code < 0x180) {
+            const char *fold = LATIN[code - 0xC0];
+            if (fold[0] == ' ') gap = true;
+            else put(fold);
+        } else if (code < 0xC0 or (code >= 0x2000 and code <= 0x206F)) {
+            //Latin-1 and general punctuation: quotes, dashes, spaces...
+            if (code == 0x2018 or code == 0x2019 or code == 0x201B or
+                code == 0x2032) {
+                //apostrophes, like the ASCII one, are dropped
+            } else {
+                gap = true;
+            }
+        } else if (code >= 0x300 and code < 0x370) {
+            //combining accents come off like the precomposed ones
+        } else {
+            put(name.substr(i, length));
+        }
+        i += length;
+    }
+    return folded;
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * add_close
+ * purpose: the misspelling half of suggest: keys sharing enough of the
+ *          text's trigrams that do not start with it
+ *
+ * parameters: the text's key, how many suggestions are wanted and the key
+ *             indices suggested so far, to add to
+ * returns:    none
+ *
+ * notes: the text's rarest trigrams say the most about it and have the
+ *        shortest key lists, so candidates come from those lists first, up
+ *        to SCAN keys in all. The VERIFY candidates that share the most of
+ *        them are then scored on all their trigrams with Dice's
+ *        coefficient: shared trigrams over the trigrams of both.
+ */
+void NameIndex::add_close(const string &wanted, size_t count,
+                          vector<size_t> &picked) const
+{
+    vector<uint32_t> mine;
+    add_grams(wanted, mine);
+    sort(mine.begin(), mine.end());
+    mine.erase(unique(mine.begin(), mine.end()), mine.end());
+
+    //the key lists of the text's trigrams, shortest first
+    vector<pair<uint32_t, uint32_t>> lists;
+    for (size_t j = 0; j < mine.size(); j++) {
+        auto at = std::lower_bound(grams.begin(), grams.end(), mine[j]);
+        if (at == grams.end() or *at != mine[j]) continue;
+        size_t g = at - grams.begin();
+        lists.push_back(make_pair(gramStart[g], gramStart[g + 1]));
+    }
+    sort(lists.begin(), lists.end(), [](const pair<uint32_t, uint32_t> &x,
+                                        const pair<uint32_t, uint32_t> &y) {
+        return x.second - x.first < y.second - y.first;
+    });
+    vector<uint32_t> hits;
+    for (size_t j = 0; j < lists.size(); j++) {
+        size_t length = lists[j].second - lists[j].first;
+        if (j > 0 and hits.size() + length > SCAN) break;
+        size_t end = min<size_t>(lists[j].second, lists[j].first + SCAN);
+        hits.insert(hits.end(), gramKeys.begin() + lists[j].first,
+                    gramKeys.begin() + end);
+    }
+
+    //count the hits of each key, and keep the keys hit most
+    sort(hits.begin(), hits.end());
+    vector<pair<uint32_t, uint32_t>> shared; //(hits, key)
+    for (size_t i = 0; i < hits.size(); ) {
+        size_t run = i;
+        while (run < hits.size() and hits[run] == hits[i]) run++;
+        shared.push_back(make_pair(run - i, hits[i]));
+        i = run;
+    }
+    size_t verify = min(max(VERIFY, 4 * count), shared.size());
+    partial_sort(shared.begin(), shared.begin() + verify, shared.end(),
+                 greater<pair<uint32_t, uint32_t>>());
+
+    struct Close {
+        size_t key;
+        double score;
+    };
+    vector<Close> close;
+    vector<uint32_t> theirs;
+    for (size_t c = 0; c < verify; c++) {
+        size_t i = shared[c].second;
+        if (key_at(i).substr(0, wanted.size()) == wanted) continue;
+        theirs.clear();
+        add_grams(key_at(i), theirs);
+        sort(theirs.begin(), theirs.end());
+        theirs.erase(unique(theirs.begin(), theirs.end()), theirs.end());
+        size_t both = 0;
+        for (size_t a = 0, b = 0; a < mine.size() and b < theirs.size(); ) {
+            if (mine[a] < theirs[b]) a++;
+            else if (theirs[b] < mine[a]) b++;
+            else { both++; a++; b++; }
+        }
+        double score = 2.0 * both / (mine.size() + theirs.size());
+        if (score >= CLOSE_ENOUGH) close.push_back(Close{i, score});
+    }
+    size_t keep = min(count - picked.size(), close.size());
+    partial_sort(close.begin(), close.begin() + keep, close.end(),
+                 [&](const Close &x, const Close &y) {
+        if (x.score != y.score) return x.score > y.score;
+        return better(x.key, y.key);
+    });
+    for (size_t i = 0; i < keep; i++) picked.push_back(close[i].key);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * key_at
+ * purpose: the i-th key in sorted order
+ */
+string_view NameIndex::key_at(size_t i) const
+{
+    return string_view(keys).substr(keyStart[i], keyStart[i + 1] -
+                                                 keyStart[i]);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * lower_bound
+ * purpose: binary search for a key
+ *
+ * parameters: a key or the start of one
+ * returns:    the index of the first key not less than it
+ */
+size_t NameIndex::lower_bound(string_view text) const
+{
+    size_t low = 0, high = keyVertex.size();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (key_at(middle) < text) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * better
+ * purpose: the order artists with equally good names are given in
+ *
+ * parameters: two key indices
+ * returns:    true if x's artist has more collaborators than y's, or as
+ *             many and a lower vertex ID
+ */
+bool NameIndex::better(size_t x, size_t y) const
+{
+    size_t xDegree = graph->degree(keyVertex[x]);
+    size_t yDegree = graph->degree(keyVertex[y]);
+    if (xDegree != yDegree) return xDegree > yDegree;
+    return keyVertex[x] < keyVertex[y];
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * add_grams
+ * purpose: list the trigrams of a key with a space at each end, so the
+ *          start and end of a name count too
+ *
+ * parameters: the key and the list to add to
+ * returns:    none
+ */
+void NameIndex::add_grams(string_view key, vector<uint32_t> &out)
+{
+    string padded = " " + string(key) + " ";
+    for (size_t i = 0; i + 3 <= padded.size(); i++) {
+        out.push_back((uint32_t) (unsigned char) padded[i] << 16 |
+                      (uint32_t) (unsigned char) padded[i + 1] << 8 |
+                      (unsigned char) padded[i + 2]);
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ ** NameIndex.h
+ **
+ ** Purpose:
+ **   Finds artists by names that are not quite right. Every artist name is
+ **   folded to a key: lower case, accents and ligatures of Latin letters
+ **   taken off, apostrophes (straight or curly) dropped, and any run of
+ **   spaces, dashes, quotes and other punctuation made one space. So
+ **   "beyonce", "BEYONCÉ" and "Beyoncé" all have the key "beyonce", and
+ **   "Don’t" and "Dont" the key "dont".
+ **
+ **   The keys are kept sorted in one buffer, which gives both an exact key
+ **   lookup and every key that starts with a prefix by binary search. For
+ **   names that are misspelled, every key is also listed under each of its
+ **   trigrams (three bytes in a row, with a space at each end of the key);
+ **   a misspelled name still shares most of its trigrams with the right one.
+ **
+ ** Notes:
+ **   1) find() only matches whole keys; when several artists have the same
+ **      key it picks the one with the most collaborators (then the lowest
+ **      vertex ID), so the answer never depends on load order
+ **   2) suggest() ranks exact keys first, then keys that start with the
+ **      text, by degree, then keys that share enough trigrams, by how many;
+ **      only the text's rarest trigrams are looked up, so a misspelling
+ **      costs about the same however many names there are
+ **   3) the index holds vertex IDs and asks the graph for names and
+ **      degrees, so it must be built again if the graph is renumbered,
+ **      and told with rebind() if the graph is moved to another object
+ **   4) memory is about the length of the names, plus 12 bytes per artist
+ **      and 4 bytes per trigram of every name
+ **
+ **/
+
+#ifndef __NAME_INDEX__
+#define __NAME_INDEX__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CollabGraph.h"
+
+class NameIndex {
+
+public:
+    NameIndex();
+
+    /* Mutators */
+    void build(const CollabGraph &graph);
+    void rebind(const CollabGraph &graph);
+
+    /* Accessors */
+    size_t              find(std::string_view name) const;
+    std::vector<size_t> suggest(std::string_view text, size_t count) const;
+    size_t              bytes() const;
+
+    static std::string  key(std::string_view name);
+
+private:
+    /* a share of trigrams a key needs to be suggested for a misspelling */
+    static constexpr double CLOSE_ENOUGH = 0.5;
+    /* keys looked at, and then scored, for misspellings (see add_close) */
+    static const size_t SCAN = 16384;
+    static const size_t VERIFY = 64;
+
+    std::string_view key_at(size_t i) const;
+    size_t           lower_bound(std::string_view text) const;
+    bool             better(size_t x, size_t y) const;
+    void             add_close(const std::string &wanted, size_t count,
+                               std::vector<size_t> &picked) const;
+    static void      add_grams(std::string_view key,
+                               std::vector<uint32_t> &out);
+
+    const CollabGraph    *graph;
+    std::string           keys;         /* every key, sorted, back to back */
+    std::vector<uint64_t> keyStart;     /* key i starts at keys[keyStart[i]] */
+    std::vector<uint32_t> keyVertex;    /* the artist of key i */
+    std::vector<uint32_t> grams;        /* every trigram, sorted */
+    std::vector<uint32_t> gramStart;    /* grams[g]'s keys start here... */
+    std::vector<uint32_t> gramKeys;     /* ...in this list of key indices */
+};
+
+#endif /* __NAME_INDEX__ */
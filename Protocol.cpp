@@ -0,0 +1,384 @@
+/* Protocol.cpp
+ * This file implements parsing of one-line JSON requests and the string
+ * escaping used when writing JSON responses for "--json" mode.
+ */
+
+#include <cstdlib>
+#include <cctype>
+#include <sstream>
+
+#include "Protocol.h"
+using namespace std;
+
+static void skip_space(const string &line, size_t &pos);
+static bool parse_string(const string &line, size_t &pos, string &result);
+static bool parse_scalar(const string &line, size_t &pos, string &result,
+                         bool &quoted);
+static bool read_hex4(const string &line, size_t &pos, unsigned long &code);
+static void append_utf8(string &result, unsigned long code);
+static bool is_number(const string &text);
+
+/*has
+ *Arguments: a member name
+ *Returns: true if the request carried that member as a scalar or a list
+ */
+bool Request::has(const string &key) const
+{
+    return fields.count(key) != 0 or lists.count(key) != 0;
+}
+
+/*get
+ *Arguments: a member name
+ *Returns: the scalar value of that member, or "" if it is missing
+ */
+string Request::get(const string &key) const
+{
+    auto itr = fields.find(key);
+    if (itr == fields.end()) return "";
+    return itr->second;
+}
+
+/*get_number
+ *Arguments: a member name and a value to use if it is missing or malformed
+ *Returns: the member as an integer
+ */
+long Request::get_number(const string &key, long fallback) const
+{
+    auto itr = fields.find(key);
+    if (itr == fields.end() or itr->second.empty()) return fallback;
+
+    char *end = nullptr;
+    long value = strtol(itr->second.c_str(), &end, 10);
+    if (*end != '\0') return fallback;
+    return value;
+}
+
+/*get_list
+ *Arguments: a member name
+ *Returns: the array of strings stored under that member (empty if missing)
+ */
+vector<string> Request::get_list(const string &key) const
+{
+    auto itr = lists.find(key);
+    if (itr == lists.end()) return vector<string>();
+    return itr->second;
+}
+
+/*parse_request
+ *Arguments: one line of input, the request to fill and an error message
+ *Returns: true if the line held a well formed request object
+ *Purpose: Reads a flat JSON object in a single pass. "id" is kept as JSON
+ *         text to echo back: a string is written out again quoted and
+ *         escaped, a number or true/false/null as it was written; any
+ *         other "id" is an error, and req.id is left "null". "cmd" is
+ *         required, and nothing but whitespace may follow the object.
+ */
+bool parse_request(const string &line, Request &req, string &error)
+{
+    size_t pos = 0;
+    req = Request();
+
+    skip_space(line, pos);
+    if (pos >= line.size() or line[pos] != '{') {
+        error = "request must be a JSON object";
+        return false;
+    }
+    pos++;
+    skip_space(line, pos);
+
+    bool first = true;
+    while (pos < line.size() and line[pos] != '}') {
+        if (not first) {
+            if (line[pos] != ',') {
+                error = "expected ',' between members";
+                return false;
+            }
+            pos++;
+            skip_space(line, pos);
+        }
+        first = false;
+
+        string key;
+        if (not parse_string(line, pos, key)) {
+            error = "expected a member name";
+            return false;
+        }
+        skip_space(line, pos);
+        if (pos >= line.size() or line[pos] != ':') {
+            error = "expected ':' after \"" + key + "\"";
+            return false;
+        }
+        pos++;
+        skip_space(line, pos);
+
+        if (pos < line.size() and line[pos] == '[') { //array of strings
+            vector<string> items;
+            pos++;
+            skip_space(line, pos);
+            while (pos < line.size() and line[pos] != ']') {
+                if (not items.empty()) {
+                    if (line[pos] != ',') {
+                        error = "expected ',' in \"" + key + "\"";
+                        return false;
+                    }
+                    pos++;
+                    skip_space(line, pos);
+                }
+                string item;
+                if (not parse_string(line, pos, item)) {
+                    error = "\"" + key + "\" must hold strings";
+                    return false;
+                }
+                items.push_back(item);
+                skip_space(line, pos);
+            }
+            if (pos >= line.size()) {
+                error = "unterminated array";
+                return false;
+            }
+            pos++; //skip ']'
+            req.lists[key] = items;
+
+        } else { //string, number or literal
+            size_t start = pos;
+            string value;
+            bool quoted = false;
+            if (not parse_scalar(line, pos, value, quoted)) {
+                error = "bad value for \"" + key + "\"";
+                return false;
+            }
+            if (key == "id") {
+                string token = line.substr(start, pos - start);
+                if (quoted) {
+                    ostringstream text;
+                    write_json_string(text, value);
+                    req.id = text.str();
+                } else if (token == "true" or token == "false" or
+                           token == "null" or is_number(token)) {
+                    req.id = token;
+                } else {
+                    req.id = "null";
+                    error = "\"id\" must be a string, a number, true, false "
+                            "or null";
+                    return false;
+                }
+            } else if (key == "cmd") {
+                req.cmd = value;
+            } else {
+                req.fields[key] = value;
+            }
+        }
+        skip_space(line, pos);
+    }
+
+    if (pos >= line.size()) {
+        error = "unterminated object";
+        return false;
+    }
+    pos++; //skip '}'
+    skip_space(line, pos);
+    if (pos < line.size()) {
+        req.id = "null";
+        error = "unexpected text after the object";
+        return false;
+    }
+    if (req.cmd.empty()) {
+        error = "missing \"cmd\"";
+        return false;
+    }
+    return true;
+}
+
+/*write_json_string
+ *Arguments: output stream and any text
+ *Returns: none
+ *Purpose: Writes the text as a quoted JSON string. Non-ASCII bytes are
+ *         passed through untouched since names are already UTF-8, and runs
+ *         of characters that need no escape are written in one piece.
+ */
+void write_json_string(ostream &out, string_view text)
+{
+    static const char hex[] = "0123456789abcdef";
+    out << '"';
+    size_t plain = 0; //start of the characters not written yet
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = text[i];
+        if (c >= 0x20 and c != '"' and c != '\\') continue;
+        out.write(text.data() + plain, i - plain); //in one piece
+        plain = i + 1;
+        if (c == '"' or c == '\\') {
+            out << '\\' << c;
+        } else if (c == '\n') {
+            out << "\\n";
+        } else if (c == '\t') {
+            out << "\\t";
+        } else if (c == '\r') {
+            out << "\\r";
+        } else {
+            out << "\\u00" << hex[c >> 4] << hex[c & 0xf];
+        }
+    }
+    out.write(text.data() + plain, text.size() - plain);
+    out << '"';
+}
+
+/*skip_space
+ *Arguments: the line and the current position
+ *Returns: none, moves the position past any whitespace
+ */
+static void skip_space(const string &line, size_t &pos)
+{
+    while (pos < line.size() and isspace((unsigned char) line[pos])) pos++;
+}
+
+/*parse_string
+ *Arguments: the line, the current position and where to store the result
+ *Returns: true if a quoted string started at the position
+ *Purpose: Reads one JSON string, decoding its escapes into UTF-8. A
+ *         malformed \u escape or an unpaired surrogate fails the string.
+ */
+static bool parse_string(const string &line, size_t &pos, string &result)
+{
+    if (pos >= line.size() or line[pos] != '"') return false;
+    pos++;
+    result.clear();
+
+    while (pos < line.size() and line[pos] != '"') {
+        char c = line[pos++];
+        if (c != '\\') {
+            result += c;
+            continue;
+        }
+        if (pos >= line.size()) return false;
+        c = line[pos++];
+        switch (c) {
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            case 't': result += '\t'; break;
+            case 'u': {
+                unsigned long code;
+                if (not read_hex4(line, pos, code)) return false;
+                if (code >= 0xdc00 and code < 0xe000) return false; //lone low
+                //a high surrogate must be followed by a low one: join the
+                //UTF-16 pair back into one code point
+                if (code >= 0xd800 and code < 0xdc00) {
+                    unsigned long low;
+                    if (pos + 2 > line.size() or line[pos] != '\\' or
+                        line[pos + 1] != 'u') {
+                        return false;
+                    }
+                    pos += 2;
+                    if (not read_hex4(line, pos, low)) return false;
+                    if (low < 0xdc00 or low >= 0xe000) return false;
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                }
+                append_utf8(result, code);
+                break;
+            }
+            default: result += c; break; //covers \" \\ and \/
+        }
+    }
+    if (pos >= line.size()) return false;
+    pos++; //skip closing quote
+    return true;
+}
+
+/*read_hex4
+ *Arguments: the line, the position after a "\u" and where to store the code
+ *Returns: true and moves the position past them if four hex digits follow
+ */
+static bool read_hex4(const string &line, size_t &pos, unsigned long &code)
+{
+    if (pos + 4 > line.size()) return false;
+    code = 0;
+    for (size_t i = 0; i < 4; i++) {
+        char c = line[pos + i];
+        if (not isxdigit((unsigned char) c)) return false;
+        code = code * 16 + (isdigit((unsigned char) c) ? c - '0'
+                                                      : tolower(c) - 'a' + 10);
+    }
+    pos += 4;
+    return true;
+}
+
+/*parse_scalar
+ *Arguments: the line, the current position, where to store the value and
+ *           whether the value was a quoted string
+ *Returns: true if a string, number or literal started at the position
+ */
+static bool parse_scalar(const string &line, size_t &pos, string &result,
+                         bool &quoted)
+{
+    quoted = (pos < line.size() and line[pos] == '"');
+    if (quoted) return parse_string(line, pos, result);
+
+    size_t start = pos;
+    while (pos < line.size() and line[pos] != ',' and line[pos] != '}' and
+           not isspace((unsigned char) line[pos])) {
+        pos++;
+    }
+    result = line.substr(start, pos - start);
+    return not result.empty();
+}
+
+/*append_utf8
+ *Arguments: a string and a unicode code point
+ *Returns: none, appends the UTF-8 encoding of the code point
+ */
+static void append_utf8(string &result, unsigned long code)
+{
+    if (code < 0x80) {
+        result += (char) code;
+    } else if (code < 0x800) {
+        result += (char) (0xc0 | (code >> 6));
+        result += (char) (0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        result += (char) (0xe0 | (code >> 12));
+        result += (char) (0x80 | ((code >> 6) & 0x3f));
+        result += (char) (0x80 | (code & 0x3f));
+    } else {
+        result += (char) (0xf0 | (code >> 18));
+        result += (char) (0x80 | ((code >> 12) & 0x3f));
+        result += (char) (0x80 | ((code >> 6) & 0x3f));
+        result += (char) (0x80 | (code & 0x3f));
+    }
+}
+
+/*is_number
+ *Arguments: an unquoted token
+ *Returns: true if the token is a JSON number: an optional minus, digits
+ *         without a leading zero, then an optional fraction and exponent
+ */
+static bool is_number(const string &text)
+{
+    size_t pos = 0;
+    if (pos < text.size() and text[pos] == '-') pos++;
+    if (pos >= text.size() or not isdigit((unsigned char) text[pos])) {
+        return false;
+    }
+    if (text[pos] == '0') {
+        pos++;
+    } else {
+        while (pos < text.size() and isdigit((unsigned char) text[pos])) pos++;
+    }
+    if (pos < text.size() and text[pos] == '.') {
+        pos++;
+        if (pos >= text.size() or not isdigit((unsigned char) text[pos])) {
+            return false;
+        }
+        while (pos < text.size() and isdigit((unsigned char) text[pos])) pos++;
+    }
+    if (pos < text.size() and (text[pos] == 'e' or text[pos] == 'E')) {
+        pos++;
+        if (pos < text.size() and (text[pos] == '+' or text[pos] == '-')) {
+            pos++;
+        }
+        if (pos >= text.size() or not isdigit((unsigned char) text[pos])) {
+            return false;
+        }
+        while (pos < text.size() and isdigit((unsigned char) text[pos])) pos++;
+    }
+    return pos == text.size();
+}
@@ -0,0 +1,48 @@
+/* Protocol.h
+ *
+ * This file holds the machine-readable query protocol used by "--json" mode.
+ * Every request is a single line holding one flat JSON object, e.g.
+ *
+ *   {"id": 7, "cmd": "not", "from": "Drake", "to": "Adele",
+ *    "exclude": ["Rihanna"]}
+ *
+ * and every response is a single line holding one JSON object that echoes
+ * the request "id" back, so clients can pipeline requests and match the
+ * answers up without parsing any prose.
+ *
+ * Only the subset of JSON the protocol needs is understood: string, number,
+ * true/false/null values and arrays of strings.
+ *
+ * April 2021
+ */
+
+#ifndef __PROTOCOL__
+#define __PROTOCOL__
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+struct Request {
+    /* the "id" member as JSON text to echo back: a quoted string, a number,
+     * true, false or null ("null" if absent or malformed) */
+    std::string id = "null";
+    std::string cmd;
+
+    /* every other scalar member (strings unescaped, numbers as written) */
+    std::unordered_map<std::string, std::string> fields;
+    /* every array-of-strings member */
+    std::unordered_map<std::string, std::vector<std::string>> lists;
+
+    bool        has(const std::string &key) const;
+    std::string get(const std::string &key) const;
+    long        get_number(const std::string &key, long fallback) const;
+    std::vector<std::string> get_list(const std::string &key) const;
+};
+
+bool parse_request(const std::string &line, Request &req, std::string &error);
+void write_json_string(std::ostream &out, std::string_view text);
+
+#endif /* __PROTOCOL__ */
@@ -0,0 +1,475 @@
+/**
+ ** SearchState.cpp
+ **
+ ** Purpose:
+ **   Per-traversal metadata for a CollabGraph, keyed by vertex ID.
+ **   See SearchState.h
+ **
+ **/
+
+#include <algorithm>
+#include <limits>
+
+#include "SearchState.h"
+
+using namespace std;
+
+const size_t SearchState::NO_VERTEX;
+const size_t SearchState::NO_DEPTH;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: nullary constructor
+ * @purpose: initialize an empty SearchState; reset() must be called with
+ *           the size of the graph before it is used
+ */
+SearchState::SearchState()
+{
+    search = 0;
+    skipping = nullptr;
+    blocking = nullptr;
+    claimCount = 0;
+    level = 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * reset
+ * purpose: prepare for a new traversal of a graph with 'vertexCount'
+ *          vertices: afterwards nothing is marked and nothing has a
+ *          predecessor
+ *
+ * parameters: the number of vertices in the graph being searched
+ * returns: none
+ *
+ * notes: only touches the arrays when the graph grew or, once every
+ *        four billion searches, when the search number wraps around
+ */
+void SearchState::reset(size_t vertexCount)
+{
+    resize(vertexCount);
+
+    search++;
+    if (search == 0) {
+        fill(marked.begin(), marked.end(), 0);
+        fill(hasPred.begin(), hasPred.end(), 0);
+        fill(hasCost.begin(), hasCost.end(), 0);
+        fill(hasDepth.begin(), hasDepth.end(), 0);
+        search = 1;
+    }
+    frontier.clear();
+    skipping = nullptr;
+    blocking = nullptr;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * resize
+ * purpose: make room for 'vertexCount' vertices without forgetting the
+ *          marks and predecessors of the current search
+ *
+ * parameters: the number of vertices in the graph being searched
+ * returns: none
+ */
+void SearchState::resize(size_t vertexCount)
+{
+    if (marked.size() < vertexCount) {
+        marked.resize(vertexCount, 0);
+        hasPred.resize(vertexCount, 0);
+        predecessor.resize(vertexCount, NO_VERTEX);
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * mark / unmark
+ * purpose: mark the given vertex as visited (or not visited)
+ *
+ * parameters: a vertex ID
+ * returns: none
+ */
+void SearchState::mark(size_t id)
+{
+    marked[id] = search;
+}
+
+void SearchState::unmark(size_t id)
+{
+    marked[id] = 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * set_predecessor
+ * purpose: record that the path to 'to' comes from 'from'
+ *
+ * parameters: 1) the vertex ID whose predecessor is set
+ *             2) the vertex ID of the predecessor
+ * returns: none
+ * note: does nothing if 'to' already has a predecessor in this search
+ */
+void SearchState::set_predecessor(size_t to, size_t from)
+{
+    if (hasPred[to] != search) {
+        hasPred[to] = search;
+        predecessor[to] = from;
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * is_marked
+ * purpose: determine whether a vertex has been visited in this search
+ *
+ * parameters: a vertex ID
+ * returns: a bool, true iff the vertex is marked
+ */
+bool SearchState::is_marked(size_t id) const
+{
+    return marked[id] == search;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_predecessor
+ * purpose: retrieve the predecessor of a vertex in this search
+ *
+ * parameters: a vertex ID
+ * returns: the predecessor's vertex ID, or NO_VERTEX if there is none
+ */
+size_t SearchState::get_predecessor(size_t id) const
+{
+    if (hasPred[id] != search) return NO_VERTEX;
+    return predecessor[id];
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * path
+ * purpose: follow the predecessors back from 'dest' to 'source'
+ *
+ * parameters: the source and destination vertex IDs
+ * returns: the vertex IDs on the path, source first and dest last, or an
+ *          empty vector if dest was not reached from source (or if they
+ *          are the same vertex)
+ */
+vector<size_t> SearchState::path(size_t source, size_t dest) const
+{
+    vector<size_t> result;
+    if (source == dest or get_predecessor(dest) == NO_VERTEX) return result;
+
+    size_t curr = dest;
+    while (curr != source and curr != NO_VERTEX) {
+        result.push_back(curr);
+        curr = get_predecessor(curr);
+    }
+    if (curr == NO_VERTEX) return vector<size_t>(); //chain never met source
+
+    result.push_back(source);
+    reverse(result.begin(), result.end());
+    return result;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * bytes
+ * purpose: report the memory the state holds, for capacity planning
+ *
+ * parameters: none
+ * returns: the bytes of every array allocated so far, including the ones
+ *          only some kinds of search allocate
+ */
+size_t SearchState::bytes() const
+{
+    return (marked.capacity() + hasPred.capacity() + hasCost.capacity() +
+            hasDepth.capacity()) * sizeof(uint32_t) +
+           (predecessor.capacity() + reached.capacity() + depth.capacity()) *
+               sizeof(size_t) +
+           cost.capacity() * sizeof(double) +
+           pathCount.capacity() * sizeof(uint64_t) +
+           claimCount * sizeof(std::atomic<uint64_t>) +
+           frontier.bytes() + combined.bytes();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * set_cost
+ * purpose: record the cost of the best path to a vertex found so far in a
+ *          weighted search
+ *
+ * parameters: a vertex ID and its cost
+ * returns: none
+ */
+void SearchState::set_cost(size_t id, double newCost)
+{
+    if (hasCost.size() < marked.size()) {
+        hasCost.resize(marked.size(), 0);
+        cost.resize(marked.size());
+    }
+    hasCost[id] = search;
+    cost[id] = newCost;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_cost
+ * purpose: retrieve the cost recorded for a vertex in this search
+ *
+ * parameters: a vertex ID
+ * returns: the cost, or infinity if the vertex has not been reached
+ */
+double SearchState::get_cost(size_t id) const
+{
+    if (id >= hasCost.size() or hasCost[id] != search) {
+        return numeric_limits<double>::infinity();
+    }
+    return cost[id];
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * replace_predecessor
+ * purpose: like set_predecessor, but overwrites a predecessor that is
+ *          already set, for searches that find better paths later
+ *
+ * parameters: 1) the vertex ID whose predecessor is set
+ *             2) the vertex ID of the predecessor
+ * returns: none
+ */
+void SearchState::replace_predecessor(size_t to, size_t from)
+{
+    hasPred[to] = search;
+    predecessor[to] = from;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * queue
+ * purpose: give weighted searches a priority queue sized to the graph; it is
+ *          emptied by every reset()
+ *
+ * parameters: none
+ * returns: a reference to the queue
+ */
+DaryHeap &SearchState::queue()
+{
+    frontier.resize(marked.size());
+    return frontier;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * visits
+ * purpose: give breadth-first searches a queue that keeps its memory from
+ *          search to search
+ *
+ * parameters: none
+ * returns: a reference to the queue; reset() does not empty it, the search
+ *          that uses it does
+ */
+vector<size_t> &SearchState::visits()
+{
+    return reached;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * claims
+ * purpose: give parallel breadth-first searches one atomic claim per vertex
+ *
+ * parameters: none
+ * returns: the claims, sized to the graph
+ *
+ * notes: a claim is a level's stamp in the top 32 bits (inverted, so newer
+ *        levels are smaller) and a queue position in the bottom 32; the
+ *        smallest claim on a vertex wins, so within a level the earliest
+ *        position does, and any claim beats one left from an older level
+ */
+atomic<uint64_t> *SearchState::claims()
+{
+    if (claimCount < marked.size()) {
+        claimed.reset(new atomic<uint64_t>[marked.size()]);
+        claimCount = marked.size();
+        for (size_t i = 0; i < claimCount; i++) {
+            claimed[i].store(UINT64_MAX, memory_order_relaxed);
+        }
+        level = 0;
+    }
+    return claimed.get();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * level_claim
+ * purpose: start a new level of a parallel breadth-first search
+ *
+ * parameters: none
+ * returns: the claim of queue position 0 in the new level; position p
+ *          claims with this plus p
+ *
+ * notes: clears the claims once every four billion levels, when the
+ *        stamp wraps around
+ */
+uint64_t SearchState::level_claim()
+{
+    level++;
+    if (level == 0) {
+        for (size_t i = 0; i < claimCount; i++) {
+            claimed[i].store(UINT64_MAX, memory_order_relaxed);
+        }
+        level = 1;
+    }
+    return (uint64_t) (uint32_t) ~level << 32;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * set_depth
+ * purpose: record how many hops from the source a vertex is; its count of
+ *          shortest paths starts over at zero
+ *
+ * parameters: a vertex ID and its depth
+ * returns: none
+ */
+void SearchState::set_depth(size_t id, size_t newDepth)
+{
+    if (hasDepth.size() < marked.size()) {
+        hasDepth.resize(marked.size(), 0);
+        depth.resize(marked.size());
+        pathCount.resize(marked.size());
+    }
+    hasDepth[id] = search;
+    depth[id] = newDepth;
+    pathCount[id] = 0;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_depth
+ * purpose: retrieve how many hops from the source a vertex is
+ *
+ * parameters: a vertex ID
+ * returns: the depth, or NO_DEPTH if the vertex has not been reached
+ */
+size_t SearchState::get_depth(size_t id) const
+{
+    if (id >= hasDepth.size() or hasDepth[id] != search) return NO_DEPTH;
+    return depth[id];
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * add_paths
+ * purpose: add to the number of shortest paths that reach a vertex
+ *
+ * preconditions: set_depth has been called on the vertex in this search
+ * parameters: a vertex ID and how many more paths reach it
+ * returns: none
+ * note: the count sticks at the largest uint64_t instead of wrapping, since
+ *       the number of shortest paths between hubs can be astronomical
+ */
+void SearchState::add_paths(size_t id, uint64_t paths)
+{
+    if (pathCount[id] > UINT64_MAX - paths) pathCount[id] = UINT64_MAX;
+    else pathCount[id] += paths;
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * get_paths
+ * purpose: retrieve the number of shortest paths that reach a vertex
+ *
+ * parameters: a vertex ID
+ * returns: the count (UINT64_MAX means at least that many), or 0 if the
+ *          vertex has not been reached
+ */
+uint64_t SearchState::get_paths(size_t id) const
+{
+    if (id >= hasDepth.size() or hasDepth[id] != search) return 0;
+    return pathCount[id];
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * skip
+ * purpose: make this search treat every vertex in 'set' as excluded
+ *
+ * parameters: a set of vertex IDs, which must outlive the search
+ * returns: none
+ * note: the first set is used in place; only when a second one arrives are
+ *       they merged into a set of our own
+ */
+void SearchState::skip(const VertexSet &set)
+{
+    add_set(skipping, combined, set);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * block_songs
+ * purpose: make this search leave out every edge whose songs are all in
+ *          'set'; an edge with at least one other song can still be used
+ *
+ * parameters: a set of song IDs, which must outlive the search
+ * returns: none
+ * note: merges the same way skip() does
+ */
+void SearchState::block_songs(const VertexSet &set)
+{
+    add_set(blocking, songUnion, set);
+}
+
+
+
+
+
+/**********************************************************************
+ ******************** private function definitions ********************
+ **********************************************************************/
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * add_set
+ * purpose: point 'current' at 'set' if it is the first one, otherwise merge
+ *          everything into 'merged' and point at that
+ */
+void SearchState::add_set(const VertexSet *&current, VertexSet &merged,
+                          const VertexSet &set)
+{
+    if (current == nullptr) {
+        current = &set;
+        return;
+    }
+    if (current != &merged) {
+        merged.clear();
+        merged.insert_all(*current);
+        current = &merged;
+    }
+    merged.insert_all(set);
+}
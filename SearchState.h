@@ -0,0 +1,135 @@
+/**
+ ** SearchState.h
+ **
+ ** Purpose:
+ **   Hold the per-traversal metadata (which vertices are marked and the
+ **   predecessor of each vertex) for a CollabGraph, keyed by vertex ID.
+ **   Keeping it out of the graph lets many searches run at once over one
+ **   shared, read-only graph; every thread simply owns its own SearchState.
+ **
+ ** Notes:
+ **   1) reset() is O(1): marks and predecessors are stamped with the number
+ **      of the search that set them, and a new search just bumps that number
+ **   2) a vertex has no predecessor until set_predecessor is called on it
+ **   3) the costs and queue used by weighted searches, and the depths and
+ **      path counts used by level-by-level searches, are only allocated the
+ **      first time a search of that kind runs
+ **   4) skip() hands a search whole exclusion lists (VertexSets) that stay
+ **      owned by the caller, and block_songs() does the same for song
+ **      filters; both are forgotten by the next reset()
+ **   5) visits() is the queue of the breadth-first searches in Traversal.h;
+ **      once one is done it lists every vertex reached, in order
+ **   6) claims() are the atomics parallel breadth-first searches settle
+ **      which vertex of a level finds each new vertex with; like marks they
+ **      are stamped, with a new stamp for every level, so they are only
+ **      cleared when the stamp wraps around. Many threads may use them and
+ **      mark, set_predecessor and is_marked at once, each on its own
+ **      vertices
+ **
+ **/
+
+#ifndef __SEARCH_STATE__
+#define __SEARCH_STATE__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DaryHeap.h"
+#include "VertexSet.h"
+
+class SearchState {
+
+public:
+    static const size_t NO_VERTEX = (size_t) -1;
+
+    SearchState();
+
+    void reset(size_t vertexCount);
+    void resize(size_t vertexCount);
+
+    /* Mutators */
+    void mark(size_t id);
+    void unmark(size_t id);
+    void set_predecessor(size_t to, size_t from);
+
+    /* Accessors */
+    bool                is_marked(size_t id) const;
+    size_t              get_predecessor(size_t id) const;
+    std::vector<size_t> path(size_t source, size_t dest) const;
+    size_t              bytes() const;
+
+    /* Weighted searches */
+    void      set_cost(size_t id, double cost);
+    double    get_cost(size_t id) const;
+    void      replace_predecessor(size_t to, size_t from);
+    DaryHeap &queue();
+
+    /* Breadth-first searches */
+    std::vector<size_t> &visits();
+
+    /* Parallel breadth-first searches */
+    std::atomic<uint64_t> *claims();
+    uint64_t               level_claim();
+
+    /* Level-by-level searches */
+    static const size_t NO_DEPTH = (size_t) -1;
+
+    void     set_depth(size_t id, size_t depth);
+    size_t   get_depth(size_t id) const;
+    void     add_paths(size_t id, uint64_t paths);
+    uint64_t get_paths(size_t id) const;
+
+    /* Exclusion lists and song filters */
+    void skip(const VertexSet &set);
+    void block_songs(const VertexSet &set);
+
+    /* in the header so the searches' inner loops can inline it */
+    bool is_skipped(size_t id) const
+    {
+        return skipping != nullptr and skipping->contains(id);
+    }
+
+    /* nullptr when every song may be used */
+    const VertexSet *blocked_songs() const
+    {
+        return blocking;
+    }
+
+    /* nullptr when no vertex is skipped */
+    const VertexSet *skipped() const
+    {
+        return skipping;
+    }
+
+private:
+    uint32_t search;
+    std::vector<uint32_t> marked;       /* == search iff marked */
+    std::vector<uint32_t> hasPred;      /* == search iff pred is valid */
+    std::vector<size_t>   predecessor;
+
+    std::vector<uint32_t> hasCost;      /* == search iff cost is valid */
+    std::vector<double>   cost;
+    DaryHeap              frontier;
+    std::vector<size_t>   reached;      /* see visits() */
+
+    std::unique_ptr<std::atomic<uint64_t>[]> claimed;  /* see claims() */
+    size_t                claimCount;
+    uint32_t              level;        /* stamp of the newest level */
+
+    std::vector<uint32_t> hasDepth;     /* == search iff depth is valid */
+    std::vector<size_t>   depth;
+    std::vector<uint64_t> pathCount;    /* shortest paths, saturating */
+
+    const VertexSet      *skipping;     /* nullptr when nothing is skipped */
+    VertexSet             combined;     /* union when skip() is called twice */
+    const VertexSet      *blocking;     /* nullptr when no song is blocked */
+    VertexSet             songUnion;    /* same for block_songs() */
+
+    static void add_set(const VertexSet *&current, VertexSet &merged,
+                        const VertexSet &set);
+};
+
+#endif /* __SEARCH_STATE__ */
@@ -0,0 +1,446 @@
+/* Server.cpp
+ * This file implements the Unix domain socket query server: an epoll event
+ * loop on the main thread that does all of the socket I/O, and a pool of
+ * worker threads that answer the requests over one shared graph.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+
+#include "Server.h"
+using namespace std;
+
+/* a client may have this many requests waiting on workers before the
+ * server stops reading from it, so one client cannot flood the queue */
+static const uint64_t MAX_IN_FLIGHT = 256;
+/* longest request line accepted before the client is dropped, and the
+ * most that is read from one client in one pass of the event loop */
+static const size_t MAX_LINE = 1 << 20;
+static const int MAX_EVENTS = 64;
+
+static void die(const string &what);
+
+/*Server
+ *Arguments: a loaded SixDegrees, the socket path and the number of workers
+ *Returns: N/A
+ *Purpose: Binds and listens on the socket and starts the worker threads.
+ *         A stale socket file left at the path is replaced.
+ */
+Server::Server(const SixDegrees &six, const string &socketPath,
+               size_t workers)
+    : six(six), path(socketPath)
+{
+    nextConn = 0;
+    stopping = false;
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        cerr << path << " is too long for a socket path." << endl;
+        exit(EXIT_FAILURE);
+    }
+    strcpy(addr.sun_path, path.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) die("socket");
+    unlink(path.c_str());
+    if (bind(listenFd, (sockaddr *) &addr, sizeof(addr)) < 0) die(path);
+    if (listen(listenFd, SOMAXCONN) < 0) die("listen");
+
+    //SIGINT/SIGTERM arrive through a descriptor instead of a handler. They
+    //are blocked before the workers start so the workers inherit the mask.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd < 0) die("signalfd");
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) die("eventfd");
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) die("epoll_create1");
+    int fds[] = {listenFd, wakeFd, signalFd};
+    for (int fd : fds) {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) die("epoll_ctl");
+    }
+
+    if (workers == 0) workers = 1;
+    for (size_t i = 0; i < workers; i++) {
+        pool.push_back(thread(&Server::worker, this));
+    }
+}
+
+/*~Server
+ *Arguments: none
+ *Returns: N/A
+ *Purpose: Stops the workers, closes every descriptor and removes the socket
+ */
+Server::~Server()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (size_t i = 0; i < pool.size(); i++) pool.at(i).join();
+
+    while (not clients.empty()) close_client(clients.begin()->first);
+    close(listenFd);
+    close(wakeFd);
+    close(signalFd);
+    close(epollFd);
+    unlink(path.c_str());
+}
+
+/*run
+ *Arguments: none
+ *Returns: N/A
+ *Purpose: The event loop. Runs until SIGINT or SIGTERM arrives.
+ */
+void Server::run()
+{
+    epoll_event events[MAX_EVENTS];
+    bool done = false;
+
+    while (not done) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            die("epoll_wait");
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            uint32_t what = events[i].events;
+
+            if (fd == listenFd) {
+                accept_clients();
+            } else if (fd == wakeFd) {
+                collect_replies();
+            } else if (fd == signalFd) {
+                done = true;
+            } else if (clients.count(fd) != 0) {
+                if (what & (EPOLLERR | EPOLLHUP)) what |= EPOLLIN;
+                if (what & EPOLLOUT) write_client(fd);
+                if ((what & EPOLLIN) and clients.count(fd) != 0) {
+                    read_client(fd);
+                }
+            }
+        }
+    }
+}
+
+/*worker
+ *Arguments: none
+ *Returns: N/A
+ *Purpose: Body of each worker thread: takes request lines off the queue,
+ *         answers them with its own SearchState and hands the replies back
+ *         to the event loop.
+ */
+void Server::worker()
+{
+    SearchState search;
+    while (true) {
+        Job job;
+        {
+            unique_lock<mutex> guard(lock);
+            ready.wait(guard, [this] { return stopping or not jobs.empty(); });
+            if (stopping) return;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        ostringstream out;
+        bool keep = six.answer_line(job.line, search, out);
+
+        Reply reply = {job.fd, job.conn, job.seq, out.str(), not keep};
+        {
+            lock_guard<mutex> guard(lock);
+            replies.push_back(reply);
+        }
+        uint64_t one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0 and errno != EAGAIN) {
+            die("eventfd write");
+        }
+    }
+}
+
+/*accept_clients
+ *Arguments: none
+ *Returns: N/A
+ *Purpose: Accepts every pending connection and starts watching it
+ */
+void Server::accept_clients()
+{
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN and errno != EWOULDBLOCK and errno != EINTR) {
+                cerr << "accept: " << strerror(errno) << endl;
+            }
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        Connection &client = clients[fd];
+        client = Connection();
+        client.conn = nextConn++;
+
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        client.events = ev.events;
+        client.watched = true;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            clients.erase(fd);
+            close(fd);
+        }
+    }
+}
+
+/*read_client
+ *Arguments: a client descriptor
+ *Returns: N/A
+ *Purpose: Drains what the client sent and queues every complete line
+ */
+void Server::read_client(int fd)
+{
+    Connection &client = clients.at(fd);
+    char buffer[65536];
+
+    while (true) {
+        ssize_t got = read(fd, buffer, sizeof(buffer));
+        if (got > 0) {
+            client.in.append(buffer, got);
+            if (client.in.size() >= MAX_LINE) break; //rest on the next pass
+            continue;
+        }
+        if (got == 0) {
+            client.peerClosed = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno != EAGAIN and errno != EWOULDBLOCK) {
+            close_client(fd);
+            return;
+        }
+        break;
+    }
+
+    if (client.in.size() > MAX_LINE and
+        client.in.find('\n') == string::npos) {
+        close_client(fd); //no newline in sight, not our protocol
+        return;
+    }
+    queue_lines(fd);
+}
+
+/*queue_lines
+ *Arguments: a client descriptor
+ *Returns: N/A
+ *Purpose: Hands the client's complete lines to the workers, up to the
+ *         in-flight limit. Lines past the limit stay buffered (and the
+ *         client is not read from) until replies have gone out.
+ */
+void Server::queue_lines(int fd)
+{
+    Connection &client = clients.at(fd);
+    size_t start = 0;
+    size_t queued = 0;
+
+    {
+        lock_guard<mutex> guard(lock);
+        while (not client.quitting and
+               client.nextSeq - client.nextReply < MAX_IN_FLIGHT) {
+            size_t end = client.in.find('\n', start);
+            if (end == string::npos) {
+                //a last request does not need a newline if the client hung up
+                if (not client.peerClosed or start == client.in.size()) break;
+                end = client.in.size();
+            }
+            Job job = {fd, client.conn, client.nextSeq++,
+                       client.in.substr(start, end - start)};
+            jobs.push_back(job);
+            start = min(end + 1, client.in.size());
+            queued++;
+        }
+    }
+    client.in.erase(0, start);
+
+    //notify once per batch instead of once per line
+    if (queued == 1) ready.notify_one();
+    else if (queued > 1) ready.notify_all();
+
+    update_events(fd);
+}
+
+/*write_client
+ *Arguments: a client descriptor
+ *Returns: N/A
+ *Purpose: Writes as much pending output as the socket takes right now
+ */
+void Server::write_client(int fd)
+{
+    Connection &client = clients.at(fd);
+    size_t sent = 0;
+
+    while (sent < client.out.size()) {
+        ssize_t put = send(fd, client.out.data() + sent,
+                           client.out.size() - sent, MSG_NOSIGNAL);
+        if (put > 0) {
+            sent += put;
+        } else if (put < 0 and errno == EINTR) {
+            continue;
+        } else if (put < 0 and (errno == EAGAIN or errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            close_client(fd);
+            return;
+        }
+    }
+    client.out.erase(0, sent);
+    update_events(fd);
+}
+
+/*collect_replies
+ *Arguments: none
+ *Returns: N/A
+ *Purpose: Picks up everything the workers finished and sends each
+ *         connection's replies in request order
+ */
+void Server::collect_replies()
+{
+    uint64_t count;
+    if (read(wakeFd, &count, sizeof(count)) < 0 and errno != EAGAIN) {
+        die("eventfd read");
+    }
+
+    vector<Reply> finished;
+    {
+        lock_guard<mutex> guard(lock);
+        finished.swap(replies);
+    }
+
+    vector<int> touched;
+    for (size_t i = 0; i < finished.size(); i++) {
+        Reply &reply = finished.at(i);
+        auto itr = clients.find(reply.fd);
+        //the client left (and maybe its fd was reused) while we worked
+        if (itr == clients.end() or itr->second.conn != reply.conn) continue;
+        itr->second.done[reply.seq] = reply;
+        touched.push_back(reply.fd);
+    }
+
+    for (size_t i = 0; i < touched.size(); i++) {
+        int fd = touched.at(i);
+        auto itr = clients.find(fd);
+        if (itr == clients.end()) continue;
+        Connection &client = itr->second;
+
+        bool moved = false;
+        while (not client.quitting and not client.done.empty() and
+               client.done.begin()->first == client.nextReply) {
+            Reply &reply = client.done.begin()->second;
+            client.out += reply.text;
+            client.quitting = reply.quit;
+            client.done.erase(client.done.begin());
+            client.nextReply++;
+            moved = true;
+        }
+        if (not moved) continue;
+
+        write_client(fd);
+        //replies went out, so there may be room for more buffered lines
+        if (clients.count(fd) != 0) queue_lines(fd);
+    }
+}
+
+/*update_events
+ *Arguments: a client descriptor
+ *Returns: N/A
+ *Purpose: Decides whether the client is finished and, if not, what epoll
+ *         should watch it for: input only while under the in-flight limit,
+ *         output only while there is something left to write.
+ */
+void Server::update_events(int fd)
+{
+    Connection &client = clients.at(fd);
+    bool idle = (client.nextSeq == client.nextReply and client.in.empty());
+
+    if (client.out.empty() and (client.quitting or
+                                (client.peerClosed and idle))) {
+        close_client(fd);
+        return;
+    }
+
+    uint32_t want = 0;
+    if (not client.peerClosed and not client.quitting and
+        client.nextSeq - client.nextReply < MAX_IN_FLIGHT) {
+        want |= EPOLLIN;
+    }
+    if (not client.out.empty()) want |= EPOLLOUT;
+
+    if (want == client.events and client.watched) return;
+
+    //epoll always reports a hang up, so a client that hung up and is only
+    //waiting on workers is taken out of the set instead of spinning the loop
+    epoll_event ev;
+    ev.events = want;
+    ev.data.fd = fd;
+    if (want == 0 and client.peerClosed) {
+        if (client.watched) epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        client.watched = false;
+    } else if (client.watched) {
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+    } else {
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        client.watched = true;
+    }
+    client.events = want;
+}
+
+/*close_client
+ *Arguments: a client descriptor
+ *Returns: N/A
+ *Purpose: Forgets the client. Replies still being worked on for it are
+ *         thrown away when they arrive.
+ */
+void Server::close_client(int fd)
+{
+    if (clients.at(fd).watched) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    close(fd);
+    clients.erase(fd);
+}
+
+/*die
+ *Arguments: what failed
+ *Returns: N/A, exits
+ *Purpose: Reports a system call failure the server cannot recover from
+ */
+static void die(const string &what)
+{
+    cerr << what << ": " << strerror(errno) << endl;
+    exit(EXIT_FAILURE);
+}
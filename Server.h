@@ -0,0 +1,99 @@
+/* Server.h
+ *
+ * This file holds the outline for the long-running query server. The graph
+ * is loaded once, then the server listens on a Unix domain socket and
+ * answers requests in the JSON protocol (see Protocol.h) from any number of
+ * clients at once:
+ *
+ *  - one thread runs an epoll event loop that accepts clients, reads their
+ *    requests and writes their replies without ever blocking
+ *  - a pool of worker threads answers the requests over the single shared
+ *    graph, each worker searching with its own SearchState
+ *
+ * A client may pipeline as many requests as it likes on one connection;
+ * replies always come back in the order the requests were sent.
+ *
+ * SIGINT or SIGTERM shut the server down cleanly.
+ */
+
+#ifndef __SERVER__
+#define __SERVER__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "6degs.h"
+
+class Server {
+public:
+    Server(const SixDegrees &six, const std::string &socketPath,
+           size_t workers);
+    ~Server();
+    void run();
+
+private:
+    /* a request line waiting for a worker */
+    struct Job {
+        int fd;
+        uint64_t conn;  /* which connection on that fd, in case of reuse */
+        uint64_t seq;   /* position of the request on its connection */
+        std::string line;
+    };
+
+    /* a worker's answer waiting to be sent back */
+    struct Reply {
+        int fd;
+        uint64_t conn;
+        uint64_t seq;
+        std::string text;
+        bool quit;
+    };
+
+    struct Connection {
+        uint64_t conn = 0;
+        std::string in;                 /* bytes read, not yet a full line */
+        std::string out;                /* bytes waiting to be written */
+        uint64_t nextSeq = 0;           /* seq of the next request read */
+        uint64_t nextReply = 0;         /* seq of the next reply to send */
+        std::map<uint64_t, Reply> done; /* replies that came back early */
+        bool peerClosed = false;        /* no more requests will arrive */
+        bool quitting = false;          /* close once 'out' is written */
+        uint32_t events = 0;            /* what epoll is watching for */
+        bool watched = false;           /* in the epoll set at all */
+    };
+
+    void worker();
+    void accept_clients();
+    void read_client(int fd);
+    void queue_lines(int fd);
+    void write_client(int fd);
+    void collect_replies();
+    void update_events(int fd);
+    void close_client(int fd);
+
+    const SixDegrees &six;
+    std::string path;
+    int listenFd;
+    int epollFd;
+    int wakeFd;     /* eventfd the workers poke when replies are ready */
+    int signalFd;   /* SIGINT/SIGTERM */
+    uint64_t nextConn;
+
+    std::unordered_map<int, Connection> clients;
+
+    std::vector<std::thread> pool;
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<Job> jobs;
+    std::vector<Reply> replies;
+    bool stopping;
+};
+
+#endif
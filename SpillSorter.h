@@ -0,0 +1,157 @@
+/**
+ ** SpillSorter.h
+ **
+ ** Purpose:
+ **   An external sort for records too many to hold in memory at once. Items
+ **   are pushed into a buffer of fixed size; each time the buffer fills it
+ **   is sorted and written to a temporary file as a run. Once everything is
+ **   pushed, next() hands the items back in ascending order by merging the
+ **   runs, reading each one through a small buffer of its own.
+ **
+ ** Notes:
+ **   1) T is compared with operator< and written to disk byte for byte, so
+ **      it must be trivially copyable (plain structs of integers)
+ **   2) memory in use is the buffer plus READ_ITEMS items per run, whatever
+ **      the number of items pushed; if the buffer never fills nothing is
+ **      written to disk at all
+ **   3) the runs are tmpfile()s, so they disappear when the sorter is
+ **      destroyed or the program exits
+ **   4) it is a template, so it is defined entirely in this header
+ **
+ **/
+
+#ifndef __SPILL_SORTER__
+#define __SPILL_SORTER__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+class SpillSorter {
+
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpillSorter writes its items to disk byte for byte");
+
+public:
+    /* bufferItems: how many items are held in memory before a spill */
+    explicit SpillSorter(size_t bufferItems)
+    {
+        limit = bufferItems < READ_ITEMS ? READ_ITEMS : bufferItems;
+        position = 0;
+    }
+
+    ~SpillSorter()
+    {
+        for (size_t i = 0; i < runs.size(); i++) fclose(runs[i].file);
+    }
+
+    SpillSorter(const SpillSorter &) = delete;
+    SpillSorter &operator=(const SpillSorter &) = delete;
+
+    /* add an item; only valid before finish() */
+    void push(const T &item)
+    {
+        buffer.push_back(item);
+        if (buffer.size() == limit) spill();
+    }
+
+    /* stop taking items and get ready to hand them back in order */
+    void finish()
+    {
+        std::sort(buffer.begin(), buffer.end());
+        if (runs.empty()) return; //everything fit in memory
+
+        if (not buffer.empty()) spill();
+        std::vector<T>().swap(buffer); //give the big buffer back
+        for (size_t i = 0; i < runs.size(); i++) {
+            rewind(runs[i].file);
+            if (refill(runs[i])) heads.push(Head{runs[i].items[0], i});
+        }
+    }
+
+    /* the next item in ascending order; false once every item is out */
+    bool next(T &item)
+    {
+        if (runs.empty()) {
+            if (position == buffer.size()) return false;
+            item = buffer[position++];
+            return true;
+        }
+        if (heads.empty()) return false;
+
+        Head head = heads.top();
+        heads.pop();
+        item = head.item;
+        Run &run = runs[head.run];
+        if (++run.at < run.items.size() or refill(run)) {
+            heads.push(Head{run.items[run.at], head.run});
+        }
+        return true;
+    }
+
+    /* how many runs went to disk */
+    size_t spills() const
+    {
+        return runs.size();
+    }
+
+private:
+    static const size_t READ_ITEMS = 4096;
+
+    struct Run {
+        FILE          *file;
+        std::vector<T> items;   /* the part of the run being merged */
+        size_t         at;
+    };
+
+    /* the smallest unmerged item of each run, smallest on top */
+    struct Head {
+        T      item;
+        size_t run;
+        bool operator<(const Head &other) const
+        {
+            return other.item < item;
+        }
+    };
+
+    void spill()
+    {
+        std::sort(buffer.begin(), buffer.end());
+        FILE *file = tmpfile();
+        if (file == nullptr or
+            fwrite(buffer.data(), sizeof(T), buffer.size(), file) !=
+                buffer.size()) {
+            if (file != nullptr) fclose(file);
+            std::string message = "cannot write a temporary file to sort in";
+            throw std::runtime_error(message.c_str());
+        }
+        runs.push_back(Run{file, std::vector<T>(), 0});
+        buffer.clear();
+    }
+
+    bool refill(Run &run)
+    {
+        run.items.resize(READ_ITEMS);
+        size_t got = fread(run.items.data(), sizeof(T), READ_ITEMS, run.file);
+        run.items.resize(got);
+        run.at = 0;
+        return got > 0;
+    }
+
+    size_t              limit;
+    std::vector<T>      buffer;
+    size_t              position;   /* next() when nothing was spilled */
+    std::vector<Run>    runs;
+    std::priority_queue<Head> heads;
+};
+
+template <typename T>
+const size_t SpillSorter<T>::READ_ITEMS;
+
+#endif /* __SPILL_SORTER__ */
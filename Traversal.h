@@ -0,0 +1,496 @@
+/**
+ ** Traversal.h
+ **
+ ** Purpose:
+ **   The breadth-first search every unweighted command runs on, written
+ **   once and specialized at compile time. A policy says which features a
+ **   search needs: stopping at a target, leaving out skipped vertices,
+ **   leaving out edges whose songs are all blocked, recording
+ **   predecessors, counting levels (which also allows a depth limit), and
+ **   giving up once a budget of vertices or time is spent.
+ **   Each combination is its own instantiation of traverse(), so a plain
+ **   bfs pays nothing in its inner loop for the features it does not use.
+ **
+ **   traverse_parallel() is the same search run level by level on several
+ **   threads, for single searches over big graphs. Each level is cut into
+ **   chunks of CHUNK vertices that the threads take from a shared counter,
+ **   in two passes: first every unvisited neighbor is claimed, with an
+ **   atomic compare-and-swap, by the earliest vertex of the level that
+ **   reaches it, and each chunk notes the claims it made in adjacency
+ **   order; then each chunk keeps the claims that were not beaten, and the
+ **   lists are joined in chunk order. That is exactly the order the serial
+ **   search queues them in, so both find the same predecessors and the
+ **   same paths.
+ **
+ **   A search can also be handed a visitor, called with every vertex as it
+ **   is found, the vertex it was found from, the edge between them and its
+ **   distance; that is how a command streams what a search reaches without
+ **   keeping predecessors or waiting for the search to end. The visitor can
+ **   end the search too, which is how a search stops at the first vertex of
+ **   a whole set of targets. And a search can start from several sources
+ **   at once: they are all queued first, so every vertex is found from the
+ **   source nearest to it.
+ **
+ ** Notes:
+ **   1) vertices already marked in the SearchState are never entered, so
+ **      exclusions are made by marking them before the search; the sources
+ **      are marked by the search itself, and one already marked is left
+ **      out (so a source listed twice is searched from once)
+ **   2) vertices are marked when they are found, so each is queued once,
+ **      and neighbors are taken in adjacency order: every policy finds the
+ **      same path the bfs command always has
+ **   3) the queue is SearchState::visits(), whose memory is reused from
+ **      search to search; afterwards it lists every vertex reached, source
+ **      first, in order of distance
+ **   4) breadth_first() picks the skip, block, depth and budget features
+ **      from the search state and the Limits at run time and calls the
+ **      matching instantiation, run in parallel if it is given threads
+ **      and no budget or visitor (budgets are for the serial search's
+ **      latency)
+ **   5) a budget is checked before each vertex is expanded: the vertex
+ **      count every time (one compare), the clock every CLOCK_EVERY
+ **      vertices. A search can reach up to one vertex's neighbors more than
+ **      its vertex budget, and a target found is always returned
+ **   6) traverse() is kept out of line: with every instantiation inlined into
+ **      the dispatch, the plain bfs loop ran about 20% slower
+ **   7) once a vertex of a level claims the target, the vertices after it
+ **      in the level are not expanded, which is where the serial search
+ **      stops too. A level smaller than PARALLEL_LEVEL runs on the calling
+ **      thread alone; threads are started per level, as only the few big
+ **      levels in the middle of a search are worth it
+ **   8) these are templates, so they are defined entirely in this header
+ **   9) a search with a visitor always runs on the calling thread, in
+ **      serial order, so the visitor needs no locking and sees the vertices
+ **      level by level exactly as the queue holds them; the default
+ **      NoVisit compiles away
+ **
+ **/
+
+#ifndef __TRAVERSAL__
+#define __TRAVERSAL__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "CollabGraph.h"
+#include "SearchState.h"
+
+/* which features one instantiation of traverse() has */
+template <bool TARGET, bool SKIP, bool BLOCK, bool RECORD, bool LEVEL,
+          bool BUDGET>
+struct BfsPolicy {
+    static const bool STOPS = TARGET;       /* return once target is found */
+    static const bool SKIPS = SKIP;         /* honor SearchState::skip */
+    static const bool BLOCKS = BLOCK;       /* honor SearchState::block_songs */
+    static const bool RECORDS = RECORD;     /* set predecessors */
+    static const bool LEVELS = LEVEL;       /* count levels, limit depth */
+    static const bool BUDGETED = BUDGET;    /* limit vertices and time */
+};
+
+enum class Outcome {
+    FOUND,          /* the target was reached */
+    NOT_FOUND,      /* everything reachable was reached, target or not */
+    DEPTH_LIMIT,    /* stopped at the depth limit with vertices left there */
+    OVER_BUDGET     /* gave up when the vertex or time budget ran out */
+};
+
+/* how far a search may go; NONE for no limit */
+struct Limits {
+    static const size_t NONE = (size_t) -1;
+
+    size_t depth = NONE;        /* hops from the source */
+    size_t visits = NONE;       /* vertices reached, the source included */
+    size_t millis = NONE;       /* wall-clock time */
+
+    bool budgeted() const
+    {
+        return visits != NONE or millis != NONE;
+    }
+};
+
+static const size_t CLOCK_EVERY = 256;  /* vertices between clock checks */
+static const size_t CHUNK = 256;        /* level vertices per parallel task */
+static const size_t PARALLEL_LEVEL = 4096;  /* smaller levels run serially */
+
+/* the visitor of a search that has none */
+struct NoVisit {
+    bool operator()(size_t, size_t, const CollabGraph::Neighbors &,
+                    size_t) const { return false; }
+};
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * seed
+ * purpose: start a search's queue with its sources
+ *
+ * parameters: the search state and 'count' sources at 'sources'
+ * returns:    none
+ *
+ * notes: sources already marked (excluded, or listed before) are left out
+ */
+inline void seed(SearchState &search, const size_t *sources, size_t count)
+{
+    std::vector<size_t> &queue = search.visits();
+    queue.clear();
+    for (size_t i = 0; i < count; i++) {
+        if (search.is_marked(sources[i])) continue;
+        search.mark(sources[i]);
+        queue.push_back(sources[i]);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * traverse
+ * purpose: one breadth-first search, with the features Policy asks for
+ *
+ * parameters: 1) the graph and 2) a search state reset for it, holding any
+ *             exclusions, skipped lists and blocked songs
+ *             3) where to start: 'sourceCount' vertices at 'sources'
+ *             4) where to stop, if Policy::STOPS
+ *             5) how far to go: the depth if Policy::LEVELS, the visits
+ *                and time if Policy::BUDGETED
+ *             6) if Policy::LEVELS and not nullptr, filled with how many
+ *                vertices are 1, 2, ... hops from the source
+ *             7) called as visit(vertex, from, edge, hops) with each
+ *                vertex found, before it is queued; hops is only counted
+ *                if Policy::LEVELS. If it returns true the search ends
+ *                there as FOUND.
+ * returns:    how the search ended
+ *
+ * notes: the sources are not visited
+ */
+template <class Policy, class Visit>
+[[gnu::noinline]]
+Outcome traverse(const CollabGraph &graph, SearchState &search,
+                 const size_t *sources, size_t sourceCount, size_t target,
+                 const Limits &limits, std::vector<size_t> *levels,
+                 Visit &visit)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point deadline;
+    if constexpr (Policy::BUDGETED) {
+        if (limits.millis != Limits::NONE) {
+            deadline = Clock::now() + std::chrono::milliseconds(limits.millis);
+        }
+    }
+
+    std::vector<size_t> &queue = search.visits();
+    seed(search, sources, sourceCount);
+
+    size_t head = 0;
+    size_t levelEnd = queue.size();   /* where the level after head's starts */
+    size_t depth = 0;       /* hops from the source to head's level */
+    if constexpr (Policy::LEVELS) {
+        if (levels != nullptr) levels->clear();
+    }
+
+    while (head < queue.size()) {
+        if constexpr (Policy::LEVELS) {
+            if (head == levelEnd) { //a whole level was found
+                if (levels != nullptr) {
+                    levels->push_back(queue.size() - levelEnd);
+                }
+                levelEnd = queue.size();
+                depth++;
+            }
+            if (depth == limits.depth) return Outcome::DEPTH_LIMIT;
+        }
+        if constexpr (Policy::BUDGETED) {
+            if (queue.size() > limits.visits) return Outcome::OVER_BUDGET;
+            if (head % CLOCK_EVERY == 0 and limits.millis != Limits::NONE and
+                Clock::now() >= deadline) return Outcome::OVER_BUDGET;
+        }
+        size_t vertex = queue[head++];
+
+        CollabGraph::Neighbors edge = graph.neighbors(vertex);
+        while (edge.next()) {
+            size_t next = edge.neighbor();
+            if (search.is_marked(next)) continue;
+            if constexpr (Policy::SKIPS) {
+                if (search.is_skipped(next)) continue;
+            }
+            if constexpr (Policy::BLOCKS) {
+                if (edge.open_song(*search.blocked_songs()) ==
+                    CollabGraph::NO_SONG) continue;
+            }
+            search.mark(next); //mark when found so it is queued once
+            if constexpr (Policy::RECORDS) {
+                search.set_predecessor(next, vertex);
+            }
+            if (visit(next, vertex, edge, depth + 1)) return Outcome::FOUND;
+            if constexpr (Policy::STOPS) {
+                if (next == target) return Outcome::FOUND;
+            }
+            queue.push_back(next);
+        }
+    }
+    return Outcome::NOT_FOUND;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * run_chunks
+ * purpose: call task(chunk) for every chunk from 0 to chunks - 1, on up to
+ *          'threads' threads, the calling thread included
+ *
+ * notes: the threads take the next chunk from a shared counter as they
+ *        finish one, so a chunk of hubs holds up only the thread on it
+ */
+template <class Task>
+void run_chunks(size_t chunks, size_t threads, const Task &task)
+{
+    std::atomic<size_t> nextChunk(0);
+    auto work = [&]() {
+        size_t chunk;
+        while ((chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) <
+               chunks) {
+            task(chunk);
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < std::min(threads, chunks); i++) {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (size_t i = 0; i < helpers.size(); i++) helpers[i].join();
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * traverse_parallel
+ * purpose: traverse(), level by level on up to 'threads' threads
+ *
+ * parameters: see traverse, plus how many threads to use
+ * returns:    how the search ended
+ *
+ * notes: 1) the vertices, predecessors and levels it finds are the serial
+ *           search's, and in the same order in visits()
+ *        2) Policy may not be BUDGETED
+ */
+template <class Policy>
+[[gnu::noinline]]
+Outcome traverse_parallel(const CollabGraph &graph, SearchState &search,
+                          const size_t *sources, size_t sourceCount,
+                          size_t target, const Limits &limits,
+                          std::vector<size_t> *levels, size_t threads)
+{
+    static_assert(not Policy::BUDGETED, "budgets are only checked serially");
+
+    std::vector<size_t> &queue = search.visits();
+    seed(search, sources, sourceCount);
+    std::atomic<uint64_t> *claims = search.claims();
+    if constexpr (Policy::LEVELS) {
+        if (levels != nullptr) levels->clear();
+    }
+
+    struct Claim {
+        size_t vertex;
+        size_t parent;      /* its position in the queue */
+    };
+    std::vector<std::vector<Claim>> made;   /* each chunk's claims */
+    size_t levelStart = 0;
+    size_t depth = 0;       /* hops from the source to this level */
+    while (levelStart < queue.size()) {
+        if constexpr (Policy::LEVELS) {
+            if (depth == limits.depth) return Outcome::DEPTH_LIMIT;
+        }
+        size_t levelEnd = queue.size();
+        size_t chunks = (levelEnd - levelStart + CHUNK - 1) / CHUNK;
+        size_t helpers = levelEnd - levelStart < PARALLEL_LEVEL ? 1 : threads;
+        uint64_t base = search.level_claim(); //position p claims base + p
+        if (made.size() < chunks) made.resize(chunks);
+
+        //every new neighbor goes to the earliest vertex of the level that
+        //reaches it, whichever thread gets there first
+        run_chunks(chunks, helpers, [&](size_t chunk) {
+            std::vector<Claim> &list = made[chunk];
+            list.clear();
+            size_t end = std::min(levelEnd, levelStart + (chunk + 1) * CHUNK);
+            for (size_t at = levelStart + chunk * CHUNK; at < end; at++) {
+                uint64_t claim = base + at;
+                if constexpr (Policy::STOPS) { //only earlier ones matter now
+                    if (claims[target].load(std::memory_order_relaxed) <
+                        claim) break;
+                }
+                CollabGraph::Neighbors edge = graph.neighbors(queue[at]);
+                while (edge.next()) {
+                    size_t next = edge.neighbor();
+                    if (search.is_marked(next)) continue;
+                    std::atomic<uint64_t> &slot = claims[next];
+                    uint64_t seen = slot.load(std::memory_order_relaxed);
+                    if (seen <= claim) continue; //an earlier vertex has it
+                    if constexpr (Policy::SKIPS) {
+                        if (search.is_skipped(next)) continue;
+                    }
+                    if constexpr (Policy::BLOCKS) {
+                        if (edge.open_song(*search.blocked_songs()) ==
+                            CollabGraph::NO_SONG) continue;
+                    }
+                    while (seen > claim) {
+                        if (slot.compare_exchange_weak(
+                                seen, claim, std::memory_order_relaxed)) {
+                            list.push_back(Claim{next, at});
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+
+        //each chunk keeps the claims no earlier vertex beat, in order
+        std::atomic<bool> found(false);
+        run_chunks(chunks, helpers, [&](size_t chunk) {
+            std::vector<Claim> &list = made[chunk];
+            size_t kept = 0;
+            for (size_t i = 0; i < list.size(); i++) {
+                Claim won = list[i];
+                if (claims[won.vertex].load(std::memory_order_relaxed) !=
+                    base + won.parent) continue;
+                search.mark(won.vertex);
+                if constexpr (Policy::RECORDS) {
+                    search.set_predecessor(won.vertex, queue[won.parent]);
+                }
+                if constexpr (Policy::STOPS) {
+                    if (won.vertex == target) found = true;
+                }
+                list[kept++] = won;
+            }
+            list.resize(kept);
+        });
+
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            for (size_t i = 0; i < made[chunk].size(); i++) {
+                queue.push_back(made[chunk][i].vertex);
+            }
+        }
+        if constexpr (Policy::STOPS) {
+            if (found) return Outcome::FOUND;
+        }
+        if constexpr (Policy::LEVELS) {
+            if (levels != nullptr and queue.size() > levelEnd) {
+                levels->push_back(queue.size() - levelEnd);
+            }
+        }
+        levelStart = levelEnd;
+        depth++;
+    }
+    return Outcome::NOT_FOUND;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * with_budget, with_blocks, with_skips
+ * purpose: the steps of breadth_first that turn run-time choices into
+ *          policy flags, one flag each
+ */
+template <bool TARGET, bool RECORD, bool LEVELS, bool SKIP, bool BLOCK,
+          class Visit>
+Outcome with_budget(const CollabGraph &graph, SearchState &search,
+                    const size_t *sources, size_t sourceCount, size_t target,
+                    const Limits &limits, std::vector<size_t> *levels,
+                    size_t threads, Visit &visit)
+{
+    if (limits.budgeted()) {
+        return traverse<BfsPolicy<TARGET, SKIP, BLOCK, RECORD, LEVELS, true>>(
+            graph, search, sources, sourceCount, target, limits, levels,
+            visit);
+    }
+    typedef BfsPolicy<TARGET, SKIP, BLOCK, RECORD, LEVELS, false> Policy;
+    if constexpr (std::is_same_v<Visit, NoVisit>) {
+        if (threads > 1) {
+            return traverse_parallel<Policy>(graph, search, sources,
+                                             sourceCount, target, limits,
+                                             levels, threads);
+        }
+    }
+    return traverse<Policy>(graph, search, sources, sourceCount, target,
+                            limits, levels, visit);
+}
+
+template <bool TARGET, bool RECORD, bool LEVELS, bool SKIP, class Visit>
+Outcome with_blocks(const CollabGraph &graph, SearchState &search,
+                    const size_t *sources, size_t sourceCount, size_t target,
+                    const Limits &limits, std::vector<size_t> *levels,
+                    size_t threads, Visit &visit)
+{
+    if (search.blocked_songs() != nullptr) {
+        return with_budget<TARGET, RECORD, LEVELS, SKIP, true>(
+            graph, search, sources, sourceCount, target, limits, levels,
+            threads, visit);
+    }
+    return with_budget<TARGET, RECORD, LEVELS, SKIP, false>(
+        graph, search, sources, sourceCount, target, limits, levels, threads,
+        visit);
+}
+
+template <bool TARGET, bool RECORD, bool LEVELS, class Visit>
+Outcome with_skips(const CollabGraph &graph, SearchState &search,
+                   const size_t *sources, size_t sourceCount, size_t target,
+                   const Limits &limits, std::vector<size_t> *levels,
+                   size_t threads, Visit &visit)
+{
+    if (search.skipped() != nullptr) {
+        return with_blocks<TARGET, RECORD, LEVELS, true>(
+            graph, search, sources, sourceCount, target, limits, levels,
+            threads, visit);
+    }
+    return with_blocks<TARGET, RECORD, LEVELS, false>(
+        graph, search, sources, sourceCount, target, limits, levels, threads,
+        visit);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * breadth_first
+ * purpose: run traverse() with the skip, block and budget features the
+ *          search state and limits need, and the rest as given
+ *
+ * parameters: see traverse; TARGET and RECORD are the policy's, and LEVELS
+ *             asks for levels to be counted, which a depth limit also does.
+ *             With more than one thread, no budget and no visitor it
+ *             runs traverse_parallel() instead. A visitor is copied in, so
+ *             one that gathers results should hold references; levels are
+ *             counted for it, so it is told every vertex's hops.
+ *             The second form searches from every one of 'sources' at
+ *             once.
+ * returns:    how the search ended
+ */
+template <bool TARGET, bool RECORD, bool LEVELS, class Visit = NoVisit>
+Outcome breadth_first(const CollabGraph &graph, SearchState &search,
+                      const std::vector<size_t> &sources, size_t target,
+                      const Limits &limits = Limits(),
+                      std::vector<size_t> *levels = nullptr,
+                      size_t threads = 1, Visit visit = Visit())
+{
+    if (LEVELS or limits.depth != Limits::NONE or
+        not std::is_same_v<Visit, NoVisit>) {
+        return with_skips<TARGET, RECORD, true>(
+            graph, search, sources.data(), sources.size(), target, limits,
+            levels, threads, visit);
+    }
+    return with_skips<TARGET, RECORD, false>(
+        graph, search, sources.data(), sources.size(), target, limits, levels,
+        threads, visit);
+}
+
+template <bool TARGET, bool RECORD, bool LEVELS, class Visit = NoVisit>
+Outcome breadth_first(const CollabGraph &graph, SearchState &search,
+                      size_t source, size_t target,
+                      const Limits &limits = Limits(),
+                      std::vector<size_t> *levels = nullptr,
+                      size_t threads = 1, Visit visit = Visit())
+{
+    if (LEVELS or limits.depth != Limits::NONE or
+        not std::is_same_v<Visit, NoVisit>) {
+        return with_skips<TARGET, RECORD, true>(graph, search, &source, 1,
+                                                target, limits, levels,
+                                                threads, visit);
+    }
+    return with_skips<TARGET, RECORD, false>(graph, search, &source, 1,
+                                             target, limits, levels, threads,
+                                             visit);
+}
+
+#endif /* __TRAVERSAL__ */
@@ -0,0 +1,117 @@
+/* VertexOrder.cpp
+ *
+ * This file implements the vertex orderings used to renumber a graph after
+ * it is loaded. See VertexOrder.h
+ *
+ * April 2021
+ */
+
+#include <algorithm>
+#include <numeric>
+
+#include "VertexOrder.h"
+
+using namespace std;
+
+static vector<size_t> by_degree(const CollabGraph &graph, bool ascending);
+static vector<size_t> breadth_first(const CollabGraph &graph,
+                                    const vector<size_t> &starts,
+                                    bool fewestFirst);
+
+/*parse_order
+ *Arguments: the name of an ordering and where to put it
+ *Returns: false if the name is not an ordering
+ *Purpose: Reads the argument of --order: file, degree, bfs or rcm
+ */
+bool parse_order(const string &name, VertexOrder &order)
+{
+    if (name == "file") order = VertexOrder::FILE_ORDER;
+    else if (name == "degree") order = VertexOrder::DEGREE;
+    else if (name == "bfs") order = VertexOrder::BFS;
+    else if (name == "rcm") order = VertexOrder::RCM;
+    else return false;
+    return true;
+}
+
+/*vertex_order
+ *Arguments: a graph and the ordering wanted
+ *Returns: the vertex IDs in their new order: entry i is the current ID of
+ *         the vertex that should become vertex i (see renumber)
+ *Purpose: Computes an ordering in O(V log V + E)
+ */
+vector<size_t> vertex_order(const CollabGraph &graph, VertexOrder order)
+{
+    vector<size_t> result;
+    if (order == VertexOrder::DEGREE) {
+        result = by_degree(graph, false);
+    } else if (order == VertexOrder::BFS) {
+        result = breadth_first(graph, by_degree(graph, false), false);
+    } else if (order == VertexOrder::RCM) {
+        result = breadth_first(graph, by_degree(graph, true), true);
+        reverse(result.begin(), result.end());
+    } else {
+        result.resize(graph.vertex_count());
+        iota(result.begin(), result.end(), 0);
+    }
+    return result;
+}
+
+/*by_degree
+ *Arguments: a graph and which way to sort
+ *Returns: every vertex ID sorted by degree, ties kept in file order
+ *Purpose: The degree ordering, and the start vertices of the other two
+ */
+static vector<size_t> by_degree(const CollabGraph &graph, bool ascending)
+{
+    vector<size_t> ids(graph.vertex_count());
+    iota(ids.begin(), ids.end(), 0);
+    stable_sort(ids.begin(), ids.end(), [&](size_t a, size_t b) {
+        return ascending ? graph.degree(a) < graph.degree(b)
+                         : graph.degree(a) > graph.degree(b);
+    });
+    return ids;
+}
+
+/*breadth_first
+ *Arguments: a graph, the vertices to start from in order of preference and
+ *           whether to take each vertex's neighbors fewest-neighbors first
+ *Returns: every vertex ID in the order a breadth-first search reaches it,
+ *         one component after another
+ *Purpose: The bfs ordering, and Cuthill-McKee before it is reversed
+ */
+static vector<size_t> breadth_first(const CollabGraph &graph,
+                                    const vector<size_t> &starts,
+                                    bool fewestFirst)
+{
+    vector<bool> seen(graph.vertex_count(), false);
+    vector<size_t> result;
+    vector<size_t> next;
+    result.reserve(graph.vertex_count());
+    
+    for (size_t s = 0; s < starts.size(); s++) {
+        if (seen[starts[s]]) continue;
+        seen[starts[s]] = true;
+        result.push_back(starts[s]);
+        
+        //'result' doubles as the queue: everything after 'head' is waiting
+        for (size_t head = result.size() - 1; head < result.size(); head++) {
+            size_t curr = result[head];
+            next.clear();
+            CollabGraph::Neighbors edge = graph.neighbors(curr);
+            while (edge.next()) {
+                size_t neighbor = edge.neighbor();
+                if (not seen[neighbor]) {
+                    seen[neighbor] = true;
+                    next.push_back(neighbor);
+                }
+            }
+            if (fewestFirst) {
+                stable_sort(next.begin(), next.end(), [&](size_t a, size_t b) {
+                    return graph.degree(a) < graph.degree(b);
+                });
+            }
+            result.insert(result.end(), next.begin(), next.end());
+        }
+    }
+    return result;
+}
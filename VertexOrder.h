@@ -0,0 +1,35 @@
+/* VertexOrder.h
+ *
+ * This file holds the orderings that can renumber a loaded graph so that
+ * artists who are searched together sit together in memory. Vertex IDs are
+ * first handed out in file order, which scatters a hub's neighbors all over
+ * the vertex array; after renumbering, a search walks through memory much
+ * more nearly in order.
+ *
+ *  - degree: the most connected artists first
+ *  - bfs:    breadth-first from the biggest hub of each component, so every
+ *            artist's neighbors get nearby IDs
+ *  - rcm:    reverse Cuthill-McKee, breadth-first from a least connected
+ *            artist with neighbors taken fewest-neighbors first, reversed;
+ *            it keeps every edge's two IDs as close together as it can
+ *
+ * Renumbering only changes IDs. Every artist keeps its neighbors in the
+ * same order, so every command finds exactly the same paths.
+ *
+ * April 2021
+ */
+
+#ifndef __VERTEX_ORDER__
+#define __VERTEX_ORDER__
+
+#include <string>
+#include <vector>
+
+#include "CollabGraph.h"
+
+enum class VertexOrder { FILE_ORDER, DEGREE, BFS, RCM };
+
+bool                parse_order(const std::string &name, VertexOrder &order);
+std::vector<size_t> vertex_order(const CollabGraph &graph, VertexOrder order);
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ ** VertexSet.cpp
+ **
+ ** Purpose:
+ **   A bitset of vertex IDs.
+ **   See VertexSet.h
+ **
+ **/
+
+#include "VertexSet.h"
+
+using namespace std;
+
+/*********************************************************************
+ ******************** public function definitions ********************
+ *********************************************************************/
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * @function: nullary constructor
+ * @purpose: initialize an empty set
+ */
+VertexSet::VertexSet()
+{
+
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * insert
+ * purpose: add a vertex to the set
+ *
+ * parameters: a vertex ID
+ * returns: none
+ * note: inserting a vertex that is already in the set does nothing
+ */
+void VertexSet::insert(size_t id)
+{
+    if (contains(id)) return;
+
+    size_t word = id / 64;
+    if (word >= bits.size()) bits.resize(word + 1, 0);
+    bits[word] |= (uint64_t) 1 << (id % 64);
+    ids.push_back(id);
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * insert_all
+ * purpose: add every member of another set to this one
+ *
+ * parameters: the other set
+ * returns: none
+ */
+void VertexSet::insert_all(const VertexSet &other)
+{
+    for (size_t i = 0; i < other.ids.size(); i++) {
+        insert(other.ids[i]);
+    }
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * clear
+ * purpose: empty the set, keeping its storage for the next use
+ *
+ * parameters: none
+ * returns: none
+ */
+void VertexSet::clear()
+{
+    for (size_t i = 0; i < ids.size(); i++) {
+        bits[ids[i] / 64] = 0;
+    }
+    ids.clear();
+}
+
+
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * size / empty / members / bytes
+ * purpose: report on what is in the set, and the memory it holds
+ */
+size_t VertexSet::size() const
+{
+    return ids.size();
+}
+
+bool VertexSet::empty() const
+{
+    return ids.empty();
+}
+
+const vector<size_t> &VertexSet::members() const
+{
+    return ids;
+}
+
+size_t VertexSet::bytes() const
+{
+    return bits.capacity() * sizeof(uint64_t) +
+           ids.capacity() * sizeof(size_t);
+}
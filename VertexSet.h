@@ -0,0 +1,54 @@
+/**
+ ** VertexSet.h
+ **
+ ** Purpose:
+ **   A set of vertex IDs stored as a bitset, one bit per vertex. It is what
+ **   exclusion lists are made of: asking whether a vertex is in the set is a
+ **   single bit test, so a search can skip thousands of excluded artists
+ **   without hashing a single name. Song filters use the same bitset over
+ **   song IDs.
+ **
+ ** Notes:
+ **   1) the set grows to fit whatever is inserted; asking about a vertex
+ **      past the end is simply "not in the set"
+ **   2) clear() only touches the words that hold members, so one set can be
+ **      refilled query after query without an O(V) wipe
+ **
+ **/
+
+#ifndef __VERTEX_SET__
+#define __VERTEX_SET__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class VertexSet {
+
+public:
+    VertexSet();
+
+    /* Mutators */
+    void insert(size_t id);
+    void insert_all(const VertexSet &other);
+    void clear();
+
+    /* Accessors */
+    size_t size() const;
+    bool   empty() const;
+    const std::vector<size_t> &members() const;
+    size_t bytes() const;
+
+    /* in the header so the searches' inner loops can inline it */
+    bool contains(size_t id) const
+    {
+        size_t word = id / 64;
+        return word < bits.size() and ((bits[word] >> (id % 64)) & 1) != 0;
+    }
+
+private:
+    std::vector<uint64_t> bits;
+    std::vector<size_t>   ids;      /* every member once, in insert order */
+};
+
+#endif /* __VERTEX_SET__ */
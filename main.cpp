@@ -1,43 +1,355 @@
-/* 
+/*
  * main.cpp
- * This file is what the user will mainly interact with, and checks for 
+ * This file is what the user will mainly interact with, and checks for
  * misproper use of command line arguments and checks if the input file is bad.
  * by Rodrigo Campos, April 18th 2021
  */
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <chrono>
 #include "6degs.h"
+#include "Server.h"
+#include "Arena.h"
+#include "NameHash.h"
+#include "NameFold.h"
 #include <fstream>
 using namespace std;
 
+static void run(SixDegrees &six, bool json, bool allSongs, istream &input,
+                ostream &output);
+static void prepare(SixDegrees &six, VertexOrder order, bool compress,
+                    const Limits &limits, size_t threads);
+static void bench_load(const char *filename);
+static void leave(bool fastExit);
+
 int main(int argc, char *argv[])
 {
+    //"--json" switches to the one-request-per-line JSON protocol,
+    //"--serve path" answers JSON requests on a Unix domain socket instead,
+    //"--all-songs" lists every shared song on each hop of a path,
+    //"--order kind" renumbers the artists after loading, "--compress"
+    //stores the edges compressed, "--build path" saves the graph as a
+    //graph file to map later instead of answering anything, "--bench n"
+    //just times n random bfs queries, "--bench-load" times reading and
+    //interning the data file's lines, "--load-memory mb" caps what
+    //loading a data file may use besides the graph before it sorts on disk,
+    //"--max-depth n", "--max-visits n" and "--time-limit ms" limit how
+    //far every bfs, not, avoid and distances may go, "--threads n" sets
+    //how many threads one of them may use on a big graph, and "--normalize"
+    //makes names that differ only in case, curly quotes or dashes the same,
+    //"--export format path" writes the graph out for other tools instead
+    //of answering anything, and "--fast-exit" leaves the graph for the
+    //operating system to take back at exit instead of freeing it
+    bool json = false;
+    bool allSongs = false;
+    const char *socketPath = nullptr;
+    const char *buildPath = nullptr;
+    const char *exportPath = nullptr;
+    GraphExport::Format format = GraphExport::Format::EDGES;
+    VertexOrder order = VertexOrder::FILE_ORDER;
+    long bench = 0;
+    bool benchLoad = false;
+    bool compress = false;
+    size_t loadMemory = GraphBuilder::DEFAULT_MEMORY;
+    long megabytes = 0;
+    Limits limits;
+    long limit = 0;
+    long threads = 0; //one per core, or one when serving (see below)
+    bool normalize = false;
+    bool fastExit = false;
+    while (argc > 1 and strncmp(argv[1], "--", 2) == 0) {
+        if (strcmp(argv[1], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[1], "--all-songs") == 0) {
+            allSongs = true;
+        } else if (strcmp(argv[1], "--serve") == 0 and argc > 2) {
+            socketPath = argv[2];
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--order") == 0 and argc > 2 and
+                   parse_order(argv[2], order)) {
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--bench") == 0 and argc > 2 and
+                   (bench = atol(argv[2])) > 0) {
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--build") == 0 and argc > 2) {
+            buildPath = argv[2];
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--export") == 0 and argc > 3 and
+                   GraphExport::parse_format(argv[2], format)) {
+            exportPath = argv[3];
+            argv += 2;
+            argc -= 2;
+        } else if (strcmp(argv[1], "--load-memory") == 0 and argc > 2 and
+                   (megabytes = atol(argv[2])) > 0) {
+            loadMemory = (size_t) megabytes << 20;
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--max-depth") == 0 and argc > 2 and
+                   (limit = atol(argv[2])) > 0) {
+            limits.depth = limit;
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--max-visits") == 0 and argc > 2 and
+                   (limit = atol(argv[2])) > 0) {
+            limits.visits = limit;
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--time-limit") == 0 and argc > 2 and
+                   (limit = atol(argv[2])) > 0) {
+            limits.millis = limit;
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--threads") == 0 and argc > 2 and
+                   (threads = atol(argv[2])) > 0) {
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "--compress") == 0) {
+            compress = true;
+        } else if (strcmp(argv[1], "--bench-load") == 0) {
+            benchLoad = true;
+        } else if (strcmp(argv[1], "--normalize") == 0) {
+            normalize = true;
+        } else if (strcmp(argv[1], "--fast-exit") == 0) {
+            fastExit = true;
+        } else {
+            argc = 0; //unknown option, fall through to the usage message
+            break;
+        }
+        argv++;
+        argc--;
+    }
+
     //check for imprroper command line
-    if (argc != 2 and argc != 3 and argc != 4) { 
-        cerr << "Usage: ./6degs dataFile [commandFile] [outputFile]\n";
+    if ((argc != 2 and argc != 3 and argc != 4) or
+        ((socketPath != nullptr or buildPath != nullptr or bench > 0 or
+          benchLoad or exportPath != nullptr) and argc != 2)) {
+        cerr << "Usage: ./6degs [--json] [--all-songs] [--order kind] "
+             << "[--compress] dataFile [commandFile] [outputFile]\n"
+             << "       ./6degs [--order kind] [--compress] "
+             << "--serve socketPath dataFile\n"
+             << "       ./6degs [--order kind] [--compress] "
+             << "--bench queries dataFile\n"
+             << "       ./6degs [--order kind] --build graphFile dataFile\n"
+             << "       ./6degs [--order kind] --export format path "
+             << "dataFile\n"
+             << "       ./6degs --bench-load dataFile\n"
+             << "where kind is file, degree, bfs or rcm, format is edges, "
+             << "names, csr, graphml\nor dot (a path ending in .gz is "
+             << "gzipped), and a graphFile made by --build\n"
+             << "can be given anywhere a dataFile can; --load-memory mb, "
+             << "--max-depth hops,\n--max-visits artists, --time-limit ms, "
+             << "--threads n, --normalize and --fast-exit may come first "
+             << "in any form\n";
         exit(EXIT_FAILURE);
     }
-    
+
+    if (benchLoad) { //time the loader's line reading and interning
+        bench_load(argv[1]);
+        return 0;
+    }
+
+    if (exportPath != nullptr) { //load once, write out for other tools
+        SixDegrees six(argv[1], loadMemory, normalize);
+        six.renumber(order);
+        six.export_to(exportPath, format);
+        leave(fastExit);
+        return 0;
+    }
+
+    if (buildPath != nullptr) { //load once, save for mapping later
+        SixDegrees six(argv[1], loadMemory, normalize);
+        six.renumber(order);
+        six.save(buildPath);
+        leave(fastExit);
+        return 0;
+    }
+
+    //the server's workers already keep every core busy, so its searches
+    //only run in parallel when asked to
+    size_t cores = thread::hardware_concurrency();
+    if (threads == 0) threads = (socketPath != nullptr or cores == 0) ? 1
+                                                                      : cores;
+
+    if (bench > 0) { //time random searches and stop
+        SixDegrees six(argv[1], loadMemory, normalize);
+        prepare(six, order, compress, limits, threads);
+        six.benchmark(bench, cout);
+        leave(fastExit);
+        return 0;
+    }
+
+    if (socketPath != nullptr) { //long-running server, one graph load
+        SixDegrees six(argv[1], loadMemory, normalize);
+        prepare(six, order, compress, limits, threads);
+        {
+            Server server(six, socketPath, thread::hardware_concurrency());
+            server.run();
+        } //the workers stop and the socket is removed before leaving
+        leave(fastExit);
+        return 0;
+    }
+
     if (argc == 3 or argc == 4) { //check to use input files.
         ifstream inputFile(argv[2]);
         if (inputFile.fail()) {
             cerr << argv[2] << " cannot be opened." << endl;
             exit(EXIT_FAILURE);
         }
-        
+
         if (argc == 3) { //check if we use cout or outputfile UwU
-            6degs six(argv[1]);
-            six.play(inputFile, cout);
-            
+            SixDegrees six(argv[1], loadMemory, normalize);
+            prepare(six, order, compress, limits, threads);
+            run(six, json, allSongs, inputFile, cout);
+            leave(fastExit);
+
         } else {
             ofstream outputFile(argv[3]);
-            6degs six(argv[1]);
-            six.play(inputFile, outputFile);
+            SixDegrees six(argv[1], loadMemory, normalize);
+            prepare(six, order, compress, limits, threads);
+            run(six, json, allSongs, inputFile, outputFile);
+            outputFile.close();
+            leave(fastExit);
         }
         inputFile.close();
-        
+
     } else {
-        6degs six(argv[1]);
-        six.play(cin, cout);
+        SixDegrees six(argv[1], loadMemory, normalize);
+        prepare(six, order, compress, limits, threads);
+        run(six, json, allSongs, cin, cout);
+        leave(fastExit);
     }
     return 0;
-}
\ No newline at end of file
+}
+
+/* prepare
+ * Renumbers the freshly loaded graph and then compresses it, in that order,
+ * as the command line asked, and sets the limits and threads of its
+ * searches
+ */
+static void prepare(SixDegrees &six, VertexOrder order, bool compress,
+                    const Limits &limits, size_t threads)
+{
+    six.renumber(order);
+    if (compress) six.compress();
+    six.set_limits(limits);
+    six.set_threads(threads);
+}
+
+/* run
+ * Picks the command loop for the protocol asked for on the command line
+ * and how paths name their songs
+ */
+static void run(SixDegrees &six, bool json, bool allSongs, istream &input,
+                ostream &output)
+{
+    six.list_all_songs(allSongs);
+    if (json) {
+        six.play_json(input, output);
+    } else {
+        six.play(input, output);
+    }
+}
+
+/* leave
+ * With --fast-exit, ends the process here, while the graph is still
+ * loaded, once the output is flushed: none of it is freed piece by piece,
+ * and the operating system takes the whole address space back at once
+ */
+static void leave(bool fastExit)
+{
+    if (not fastExit) return;
+    cout.flush();
+    cerr.flush();
+    fflush(nullptr);
+    _Exit(EXIT_SUCCESS);
+}
+
+/* bench_load
+ * Times the two halves of loading a data file, reading lines and interning
+ * them as names, first the old way (getline, std::string keys and
+ * std::hash), then the way the loader does it now (LineReader,
+ * string_view keys in an Arena and NameHash), and then that again with
+ * every line normalized first, as --normalize does
+ */
+static void bench_load(const char *filename)
+{
+    typedef chrono::steady_clock Clock;
+    size_t lines = 0, distinct = 0;
+
+    ifstream plain(filename);
+    if (plain.fail()) {
+        cerr << filename << " cannot be opened." << endl;
+        exit(EXIT_FAILURE);
+    }
+    auto start = Clock::now();
+    string line;
+    unordered_map<string, size_t> oldIds;
+    while (not getline(plain, line).fail()) {
+        oldIds.insert({line, oldIds.size()});
+        lines++;
+    }
+    double oldMs = chrono::duration<double, milli>(Clock::now() - start)
+                       .count();
+    distinct = oldIds.size();
+
+    LineReader reader(filename);
+    start = Clock::now();
+    string_view view;
+    Arena arena;
+    pmr::unordered_map<string_view, size_t, NameHash> newIds(&arena);
+    while (reader.next(view)) {
+        if (newIds.find(view) == newIds.end()) {
+            newIds.insert({arena.copy_string(view), newIds.size()});
+        }
+    }
+    double newMs = chrono::duration<double, milli>(Clock::now() - start)
+                       .count();
+
+    LineReader folding(filename);
+    start = Clock::now();
+    Arena foldArena;
+    pmr::unordered_map<string_view, size_t, NameHash> foldIds(&foldArena);
+    string scratch;
+    size_t changed = 0;
+    while (folding.next(view)) {
+        string_view key = NameFold::fold(view, scratch);
+        if (key.data() != view.data()) changed++;
+        if (foldIds.find(key) == foldIds.end()) {
+            foldIds.insert({foldArena.copy_string(key), foldIds.size()});
+        }
+    }
+    double foldMs = chrono::duration<double, milli>(Clock::now() - start)
+                        .count();
+
+    //the scans alone, without interning
+    ifstream again(filename);
+    start = Clock::now();
+    size_t bytes = 0;
+    while (not getline(again, line).fail()) bytes += line.size();
+    double oldScan = chrono::duration<double, milli>(Clock::now() - start)
+                         .count();
+    LineReader rescan(filename);
+    start = Clock::now();
+    size_t viewBytes = 0;
+    while (rescan.next(view)) viewBytes += view.size();
+    double newScan = chrono::duration<double, milli>(Clock::now() - start)
+                         .count();
+
+    cout << lines << " lines, " << distinct << " distinct ("
+         << (distinct == newIds.size() and bytes == viewBytes ? "both agree"
+                                                              : "MISMATCH")
+         << ")\n"
+         << "getline:               " << oldScan << " ms\n"
+         << "LineReader:            " << newScan << " ms\n"
+         << "getline + std::hash:   " << oldMs << " ms\n"
+         << "LineReader + NameHash: " << newMs << " ms\n"
+         << "... + NameFold:        " << foldMs << " ms (" << changed
+         << " lines changed, " << foldIds.size() << " distinct)" << endl;
+}